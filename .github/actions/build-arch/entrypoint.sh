@@ -4,4 +4,5 @@ set -e
 cd $GITHUB_WORKSPACE
 meson build-docker-arch
 ninja -C build-docker-arch
-
+# Golden images are not committed yet, generate them here with ZEN_UPDATE_GOLDEN=1
+meson test -C build-docker-arch --no-suite render
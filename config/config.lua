@@ -52,18 +52,16 @@ local function find_level(table, level)
 end
 
 local function icon(p)
-    local color = p["color"] or TEXT_COLOR
-    local icon = p["icon"]
-    local size = p["size"] or ICON_SIZE
-    return "<span size='" .. size .. "' color='" .. color .. "'>" .. icon .. "</span>"
+    return zen.u.span{text = p["icon"], size = p["size"] or ICON_SIZE, color = p["color"] or TEXT_COLOR}
 end
 
 local function label(p)
-    local color = p["color"] or TEXT_COLOR
-    local label = p["label"]
-    local size = p["size"] or TEXT_SIZE
-    local rise = p["rise"] or TEXT_RISE
-    return "<span size='" .. size .. "' rise='" .. rise .. "' color='" .. color .. "'>" .. label .. "</span>"
+    return zen.u.span{
+        text = p["label"],
+        size = p["size"] or TEXT_SIZE,
+        rise = p["rise"] or TEXT_RISE,
+        color = p["color"] or TEXT_COLOR,
+    }
 end
 
 local function box(markup, color)
@@ -77,10 +75,11 @@ local function box(markup, color)
     }
 end
 
-local function wsbox(markup, color)
+local function wsbox(markup, color, max_width)
     return {
         type = "box",
         markup = markup,
+        max_width = max_width,
         color = color,
         padding = { top = 17, left = 10, right = 10, bottom = 17 },
         radius = 15,
@@ -112,10 +111,10 @@ local function render_workspaces(displayName)
         end
         local items = {
             wsbox(label{label=" " .. zen.u.html_escape(workspace.name) .. " "}, boxcolor),
-            wsbox(label{label=zen.u.html_escape(app_name)}, boxcolor),
+            wsbox(label{label=zen.u.html_escape(app_name)}, boxcolor, 400),
         }
         if app_alert ~= "" and app_alert ~= app_name then
-            table.insert(items, wsbox(label{label=zen.u.html_escape(app_alert)}, RED))
+            table.insert(items, wsbox(label{label=zen.u.html_escape(app_alert)}, RED, 400))
         end
         local workspace = {
             type = "flex",
@@ -130,16 +129,31 @@ local function render_workspaces(displayName)
 end
 
 local function click_workspace(tag)
-    os.execute('swaymsg workspace "' .. tag .. '"')
+    zen.spawn({ "swaymsg", "workspace", tag })
 end
 
+local alert_icons = {
+    power = "󰂃",
+    network = "󰖪",
+    window = "󰭺",
+}
+
 local function render_alert()
+    -- Alerts are sorted with highest priority first
+    local alert = zen.alerts[1]
+    if not alert then
+        return ""
+    end
+    local color = RED
+    if alert.priority == "low" or alert.priority == "normal" then
+        color = YELLOW
+    end
     local box = {
       type = "box",
-      markup = icon{icon="󰭺", size=ICON_SIZE},
+      markup = icon{icon=alert_icons[alert.kind], size=ICON_SIZE},
       padding = { top = 0, left = 13, right = 13, bottom = 0 },
       radius = 20,
-      color = RED,
+      color = color,
     }
     return {
       type = "flex",
@@ -176,7 +190,7 @@ local function render_audio()
 end
 
 local function click_audio()
-  os.execute("pactl set-sink-mute @DEFAULT_SINK@ toggle")
+  zen.spawn({ "pactl", "set-sink-mute", "@DEFAULT_SINK@", "toggle" })
 end
 
 local function wheel_audio(tag, value)
@@ -186,7 +200,7 @@ local function wheel_audio(tag, value)
   else
     prefix = "-"
   end
-  os.execute("pactl set-sink-volume @DEFAULT_SINK@ " .. prefix .. "10000")
+  zen.spawn({ "pactl", "set-sink-volume", "@DEFAULT_SINK@", prefix .. "10000" })
 end
 
 local function click_keyboard()
@@ -194,7 +208,7 @@ local function click_keyboard()
     if zen.keyboard.layout == "Swedish" then
         layout = "us"
     end
-    os.execute('swaymsg input type:keyboard xkb_layout "' .. layout .. '"')
+    zen.spawn({ "swaymsg", "input", "type:keyboard", "xkb_layout", layout })
 end
 
 local function render_power()
@@ -264,8 +278,11 @@ return {
     alert = {
         anchor = "topright",
         widgets = {
-            { padding = { top = 10 }, on_render = render_alert },
+            { sources = {'alerts'}, padding = { top = 10 }, on_render = render_alert },
         },
         on_display = is_focused_display,
+        -- Milliseconds until an alert expires, 0 keeps it until cleared or seen
+        timeout = 0,
+        timeouts = { network = 60000, window = 30000 },
     },
 }
@@ -0,0 +1,93 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <lua.hpp>
+#include <thread>
+#include <vector>
+
+#include "zen/BytecodeCache.h"
+
+namespace fs = std::filesystem;
+
+// Loads and runs the chunk, returning the number it returns
+static int Run(lua_State* L, BytecodeCache& cache, const fs::path& path) {
+    REQUIRE(cache.Load(L, path) == LUA_OK);
+    REQUIRE(lua_pcall(L, 0, 1, 0) == LUA_OK);
+    const int result = (int)lua_tointeger(L, -1);
+    lua_pop(L, 1);
+    return result;
+}
+
+TEST_CASE("Chunks are loaded from cache until source changes", "[bytecode]") {
+    const auto dir = fs::temp_directory_path() / "zenway-bytecode-cache";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "config");
+    const auto path = dir / "config" / "config.lua";
+    std::ofstream(path) << "return 1";
+    auto L = luaL_newstate();
+    luaL_openlibs(L);
+    BytecodeCache cache(dir / "cache");
+
+    REQUIRE(Run(L, cache, path) == 1);
+    REQUIRE(cache.Misses() == 1);
+    REQUIRE(Run(L, cache, path) == 1);
+    REQUIRE(cache.Hits() == 1);
+
+    std::ofstream(path) << "return 2";
+    REQUIRE(Run(L, cache, path) == 2);
+    REQUIRE(cache.Misses() == 2);
+
+    // Required modules go through the cache as well
+    std::ofstream(dir / "config" / "module.lua") << "return 3";
+    cache.InstallSearcher(L);
+    const auto script = "package.path = '" + (dir / "config" / "?.lua").string() +
+                        "'; return require('module')";
+    REQUIRE(luaL_dostring(L, script.c_str()) == LUA_OK);
+    REQUIRE(lua_tointeger(L, -1) == 3);
+    REQUIRE(cache.Misses() == 3);
+
+    // First line skipped like luaL_loadfile, line numbers are kept
+    std::ofstream(path) << "#!/usr/bin/lua\nreturn debug.getinfo(1, 'l').currentline";
+    REQUIRE(Run(L, cache, path) == 2);
+    REQUIRE(Run(L, cache, path) == 2);
+
+    // Syntax errors are reported like luaL_loadfile
+    std::ofstream(path) << "return (";
+    REQUIRE(cache.Load(L, path) == LUA_ERRSYNTAX);
+    lua_close(L);
+    fs::remove_all(dir);
+}
+
+TEST_CASE("Chunks are cached from several threads", "[bytecode]") {
+    const auto dir = fs::temp_directory_path() / "zenway-bytecode-threads";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const auto path = dir / "poll.lua";
+    std::ofstream(path) << "return 4";
+    BytecodeCache cache(dir / "cache");
+    // Results are checked on the test thread
+    std::vector<int> results(8);
+    std::vector<std::thread> threads;
+    for (auto& result : results) {
+        threads.emplace_back([&cache, &path, &result] {
+            auto L = luaL_newstate();
+            for (int i = 0; i < 10; i++) {
+                if (cache.Load(L, path) == LUA_OK && lua_pcall(L, 0, 1, 0) == LUA_OK) {
+                    result += (int)lua_tointeger(L, -1);
+                }
+                lua_settop(L, 0);
+            }
+            lua_close(L);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto result : results) {
+        REQUIRE(result == 40);
+    }
+    REQUIRE(cache.Hits() + cache.Misses() == 80);
+    // Only the entry is left, no temporary files
+    REQUIRE(std::distance(fs::directory_iterator(dir / "cache"), fs::directory_iterator()) == 1);
+    fs::remove_all(dir);
+}
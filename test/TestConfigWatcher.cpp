@@ -0,0 +1,50 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+
+#include "zen/ConfigWatcher.h"
+
+namespace fs = std::filesystem;
+
+static void Write(const fs::path& path, const char* content) { std::ofstream(path) << content; }
+
+TEST_CASE("Changes to watched files are reported once per batch", "[config]") {
+    const auto dir = fs::temp_directory_path() / "zenway-config-watcher";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const auto config = dir / "config.lua";
+    const auto module = dir / "module.lua";
+    Write(config, "return {}");
+    Write(module, "return {}");
+
+    auto mainLoop = std::shared_ptr<MainLoop>(MainLoop::Create());
+    int changes = 0;
+    std::vector<std::string> files = {config};
+    auto watcher = ConfigWatcher::Create(mainLoop, [&changes, &files]() {
+        changes++;
+        return files;
+    });
+    REQUIRE(watcher);
+    watcher->Watch(files);
+
+    // Other files in the directory are ignored
+    Write(module, "return { changed = true }");
+    REQUIRE_FALSE(watcher->OnRead());
+    REQUIRE(changes == 0);
+
+    Write(config, "return { panels = {} }");
+    Write(config, "return { panels = {} }");
+    watcher->OnRead();
+    REQUIRE(changes == 1);
+
+    // Replaced by rename like editors save, and the watched files are updated
+    files.push_back(module);
+    Write(dir / "config.lua.tmp", "return {}");
+    fs::rename(dir / "config.lua.tmp", config);
+    watcher->OnRead();
+    REQUIRE(changes == 2);
+    Write(module, "return {}");
+    watcher->OnRead();
+    REQUIRE(changes == 3);
+    fs::remove_all(dir);
+}
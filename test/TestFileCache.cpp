@@ -0,0 +1,49 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+
+#include "zen/FileCache.h"
+
+namespace fs = std::filesystem;
+
+static void Write(const fs::path& path, const char* content) { std::ofstream(path) << content; }
+
+TEST_CASE("Files are read once until changed", "[fs]") {
+    const auto dir = fs::temp_directory_path() / "zenway-file-cache";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const auto path = dir / "state";
+    Write(path, "up\nwg0\n");
+    auto& cache = FileCache::Shared();
+    REQUIRE(cache.Fd() >= 0);
+
+    auto file = cache.Read(path);
+    REQUIRE(file);
+    REQUIRE(file->content == "up\nwg0\n");
+    REQUIRE(file->lines.size() == 2);
+    REQUIRE(file->lines[1] == "wg0");
+    REQUIRE(cache.Read(path) == file);
+
+    // Other files in the directory are ignored
+    Write(dir / "other", "");
+    REQUIRE_FALSE(cache.Invalidate());
+    REQUIRE(cache.Read(path) == file);
+
+    // Replaced by rename
+    Write(dir / "state.tmp", "down");
+    fs::rename(dir / "state.tmp", path);
+    REQUIRE(cache.Invalidate());
+    file = cache.Read(path);
+    REQUIRE(file->content == "down");
+    REQUIRE(file->lines.size() == 1);
+
+    // Missing until created
+    const auto missing = dir / "missing";
+    REQUIRE_FALSE(cache.Read(missing));
+    Write(missing, "");
+    REQUIRE(cache.Invalidate());
+    file = cache.Read(missing);
+    REQUIRE(file);
+    REQUIRE(file->lines.empty());
+    fs::remove_all(dir);
+}
@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "zen/LuaAllocator.h"
+
+struct Block {
+    uint8_t* ptr;
+    size_t size;
+    uint8_t fill;
+};
+
+static bool IsFilled(const Block& block, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (block.ptr[i] != block.fill) return false;
+    }
+    return true;
+}
+
+TEST_CASE("Small blocks are recycled", "[allocator]") {
+    LuaAllocator allocator;
+    auto a = LuaAllocator::Alloc(&allocator, nullptr, 4 /* type tag */, 24);
+    LuaAllocator::Alloc(&allocator, a, 24, 0);
+    // Same size class gets the freed block back
+    auto b = LuaAllocator::Alloc(&allocator, nullptr, 4, 30);
+    REQUIRE(a == b);
+    // Growing within size class stays in place
+    REQUIRE(LuaAllocator::Alloc(&allocator, b, 30, 32) == b);
+    REQUIRE(allocator.Allocated() == 24 + 30 + 2);
+    REQUIRE(allocator.ChunkBytes() == LuaAllocator::CHUNK_SIZE);
+    LuaAllocator::Alloc(&allocator, b, 32, 0);
+}
+
+TEST_CASE("Reallocation keeps contents across size classes", "[allocator]") {
+    LuaAllocator allocator;
+    std::mt19937 random(17);
+    std::vector<Block> blocks;
+    for (int i = 0; i < 20000; i++) {
+        const auto op = random() % 3;
+        if (op == 0 || blocks.empty()) {
+            // Mostly small, sometimes large
+            const size_t size = random() % 8 == 0 ? 1 + random() % 4096 : 1 + random() % 256;
+            auto ptr = static_cast<uint8_t*>(LuaAllocator::Alloc(&allocator, nullptr, 5, size));
+            REQUIRE(ptr);
+            const auto fill = uint8_t(random());
+            memset(ptr, fill, size);
+            blocks.push_back(Block{.ptr = ptr, .size = size, .fill = fill});
+            continue;
+        }
+        auto& block = blocks[random() % blocks.size()];
+        if (op == 1) {
+            const size_t size = 1 + random() % 512;
+            auto ptr = static_cast<uint8_t*>(
+                LuaAllocator::Alloc(&allocator, block.ptr, block.size, size));
+            REQUIRE(ptr);
+            block.ptr = ptr;
+            REQUIRE(IsFilled(block, std::min(block.size, size)));
+            block.size = size;
+            memset(block.ptr, block.fill, size);
+            continue;
+        }
+        REQUIRE(IsFilled(block, block.size));
+        LuaAllocator::Alloc(&allocator, block.ptr, block.size, 0);
+        block = blocks.back();
+        blocks.pop_back();
+    }
+    for (const auto& block : blocks) {
+        REQUIRE(IsFilled(block, block.size));
+        LuaAllocator::Alloc(&allocator, block.ptr, block.size, 0);
+    }
+}
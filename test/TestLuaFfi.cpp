@@ -0,0 +1,58 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string_view>
+
+#include "zen/LuaFfi.h"
+
+static std::string_view View(const zen_string& s) { return std::string_view(s.data, s.size); }
+
+static Displays TestDisplays() {
+    auto first = Display("FAKE-1");
+    auto code = Workspace("1");
+    code.applications.push_back(
+        Application{.name = "vim", .appId = "Alacritty", .isFocused = true, .isAlerted = false});
+    code.applications.push_back(
+        Application{.name = "htop", .appId = "Alacritty", .isFocused = false, .isAlerted = true});
+    first.workspaces.push_back(std::move(code));
+    first.workspaces.push_back(Workspace("2"));
+    auto second = Display("FAKE-2");
+    auto web = Workspace("3");
+    web.applications.push_back(
+        Application{.name = "firefox", .appId = "firefox", .isFocused = false, .isAlerted = false});
+    second.workspaces.push_back(std::move(web));
+    return {first, second};
+}
+
+TEST_CASE("Displays are flattened with arrays pointing into storage", "[ffi]") {
+    FfiDisplays ffi;
+    ffi.Update(TestDisplays());
+    REQUIRE(ffi.root.count == 2);
+    const auto& first = ffi.root.items[0];
+    REQUIRE(View(first._name) == "FAKE-1");
+    REQUIRE(first.workspaces.count == 2);
+    REQUIRE(View(first.workspaces.items[0]._name) == "1");
+    REQUIRE(first.workspaces.items[0].applications.count == 2);
+    REQUIRE(View(first.workspaces.items[0].applications.items[1]._name) == "htop");
+    REQUIRE(first.workspaces.items[0].applications.items[1].alert);
+    REQUIRE(first.workspaces.items[1].applications.count == 0);
+    const auto& second = ffi.root.items[1];
+    REQUIRE(View(second.workspaces.items[0]._name) == "3");
+    REQUIRE(View(second.workspaces.items[0].applications.items[0]._appid) == "firefox");
+
+    // Root stays in place when updated
+    const auto root = &ffi.root;
+    ffi.Update({Display("FAKE-3")});
+    REQUIRE(&ffi.root == root);
+    REQUIRE(ffi.root.count == 1);
+    REQUIRE(View(ffi.root.items[0]._name) == "FAKE-3");
+    REQUIRE(ffi.root.items[0].workspaces.count == 0);
+}
+
+TEST_CASE("Networks keep strings alive", "[ffi]") {
+    FfiNetworks ffi;
+    ffi.Update({{"eth0", {.isAlerted = false, .isUp = false, .address = ""}},
+                {"wlan0", {.isAlerted = false, .isUp = true, .address = "10.0.0.17"}}});
+    REQUIRE(ffi.root.count == 2);
+    REQUIRE(View(ffi.root.items[0]._interface) == "eth0");
+    REQUIRE(ffi.root.items[1].up);
+    REQUIRE(View(ffi.root.items[1]._address) == "10.0.0.17");
+}
@@ -0,0 +1,34 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lua.hpp>
+
+#include "zen/LuaWatchdog.h"
+#include "zen/Metrics.h"
+
+// Runs chunk watched with budget, returns true if it was aborted
+static bool Run(lua_State* L, const char* chunk, std::chrono::microseconds budget) {
+    REQUIRE(luaL_loadstring(L, chunk) == LUA_OK);
+    const auto id = LuaWatchdog::Shared().Begin(L, budget);
+    const int status = lua_pcall(L, 0, 0, 0);
+    const bool isAborted = LuaWatchdog::Shared().End(id);
+    if (status != LUA_OK) {
+        lua_pop(L, 1);
+    }
+    REQUIRE((status != LUA_OK) == isAborted);
+    return isAborted;
+}
+
+TEST_CASE("Calls over budget are aborted", "[watchdog]") {
+    using std::chrono::milliseconds;
+    auto L = luaL_newstate();
+    luaL_openlibs(L);
+    const auto overruns = Metrics::Shared().Get("lua.overruns");
+    REQUIRE_FALSE(Run(L, "local n = 0 for i = 1, 1000 do n = n + i end", milliseconds(1000)));
+    REQUIRE(Run(L, "while true do end", milliseconds(20)));
+    // Caught errors are raised again
+    REQUIRE(Run(L, "while true do pcall(function() while true do end end) end",
+                milliseconds(20)));
+    REQUIRE(Metrics::Shared().Get("lua.overruns") - overruns == 2);
+    // State is still usable and no longer hooked
+    REQUIRE_FALSE(Run(L, "for i = 1, 100000 do end", milliseconds(0)));
+    lua_close(L);
+}
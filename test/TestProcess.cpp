@@ -0,0 +1,69 @@
+#include <poll.h>
+#include <signal.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <optional>
+
+#include "zen/Process.h"
+
+// Main loop is not run, the process is polled until it has exited
+static std::optional<int> WaitForExit(Process& process, std::optional<int>& status) {
+    for (int i = 0; i < 500 && !status; i++) {
+        poll(nullptr, 0, 10);
+        const bool dirty = process.OnRead();
+        // Callbacks invoked makes the handler dirty
+        if (status) {
+            REQUIRE(dirty);
+        }
+    }
+    return status;
+}
+
+TEST_CASE("Output is delivered by line and exit status when exited", "[process]") {
+    auto mainLoop = std::shared_ptr<MainLoop>(MainLoop::Create());
+    REQUIRE(mainLoop);
+    std::vector<std::string> lines;
+    std::optional<int> status;
+    auto process = Process::Spawn(
+        mainLoop, {"sh", "-c", "echo first; printf 'second\\nlast'; exit 3"},
+        {.onOutput = [&lines](std::string_view line) { lines.emplace_back(line); },
+         .onExit = [&status](int exitStatus) { status = exitStatus; }});
+    REQUIRE(process);
+    REQUIRE(process->Pid() > 0);
+    REQUIRE(WaitForExit(*process, status) == 3);
+    REQUIRE(lines == std::vector<std::string>({"first", "second", "last"}));
+}
+
+TEST_CASE("Killed processes report signal", "[process]") {
+    auto mainLoop = std::shared_ptr<MainLoop>(MainLoop::Create());
+    std::optional<int> status;
+    auto process = Process::Spawn(
+        mainLoop, {"sh", "-c", "kill -9 $$"},
+        {.onOutput = nullptr, .onExit = [&status](int exitStatus) { status = exitStatus; }});
+    REQUIRE(process);
+    REQUIRE(WaitForExit(*process, status) == 128 + 9);
+}
+
+TEST_CASE("Missing programs fail to spawn", "[process]") {
+    auto mainLoop = std::shared_ptr<MainLoop>(MainLoop::Create());
+    REQUIRE_FALSE(Process::Spawn(mainLoop, {"zenway-no-such-program"}, {}));
+    REQUIRE_FALSE(Process::Spawn(mainLoop, {}, {}));
+}
+
+TEST_CASE("Signals blocked by zenway are not blocked in children", "[process]") {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    auto mainLoop = std::shared_ptr<MainLoop>(MainLoop::Create());
+    std::vector<std::string> lines;
+    std::optional<int> status;
+    auto process = Process::Spawn(
+        mainLoop, {"grep", "SigBlk", "/proc/self/status"},
+        {.onOutput = [&lines](std::string_view line) { lines.emplace_back(line); },
+         .onExit = [&status](int exitStatus) { status = exitStatus; }});
+    pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
+    REQUIRE(process);
+    REQUIRE(WaitForExit(*process, status) == 0);
+    REQUIRE(lines == std::vector<std::string>({"SigBlk:\t0000000000000000"}));
+}
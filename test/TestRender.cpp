@@ -0,0 +1,263 @@
+// Renders the panels of a configuration from recorded source states without any
+// compositor and compares the result with golden images. Frame timings are written
+// to render-timings.csv in the output directory.
+//
+// Environment:
+//   ZEN_CONFIG         Configuration to render
+//   ZEN_RENDER_DIR     Directory with config.lua wrapper and golden images
+//   ZEN_OUTPUT_DIR     Where rendered images and timings are written
+//   ZEN_UPDATE_GOLDEN  Set to replace golden images with rendered ones
+#include <spdlog/spdlog.h>
+
+#include <catch2/catch_message.hpp>
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+#include "zen/Buffer.h"
+#include "zen/Draw.h"
+#include "zen/HeadlessSurface.h"
+#include "zen/Metrics.h"
+#include "zen/ScriptContext.h"
+
+namespace fs = std::filesystem;
+
+static const std::string OUTPUT_NAME = "HEADLESS-1";
+static const int TIMED_FRAMES = 50;
+
+// Recorded state of all sources used by the configuration
+struct RecordedState {
+    std::string name;
+    Displays displays;
+    PowerState power;
+    AudioState audio;
+    KeyboardState keyboard;
+    Networks networks;
+    Alerts alerts;
+};
+
+static Display RecordedDisplay(bool alerted) {
+    auto display = Display(OUTPUT_NAME);
+    display.isFocused = true;
+    auto code = Workspace("1");
+    code.isFocused = true;
+    code.applications.push_back(Application{
+        .name = "vim zen/Draw.cpp", .appId = "Alacritty", .isFocused = true, .isAlerted = false});
+    display.workspaces.push_back(std::move(code));
+    auto web = Workspace("2");
+    web.applications.push_back(
+        Application{.name = "A very long window title that is expected to be ellipsized by zenway",
+                    .appId = "firefox",
+                    .isFocused = false,
+                    .isAlerted = alerted});
+    web.isAlerted = alerted;
+    display.isAlerted = alerted;
+    display.workspaces.push_back(std::move(web));
+    display.workspaces.push_back(Workspace("3"));
+    return display;
+}
+
+static std::vector<RecordedState> RecordedStates() {
+    return {
+        RecordedState{
+            .name = "normal",
+            .displays = {RecordedDisplay(false)},
+            .power =
+                {.IsAlerted = false, .IsPluggedIn = false, .IsCharging = false, .Capacity = 64},
+            .audio = {.Muted = false, .Volume = 42, .PortType = "speaker"},
+            .keyboard = {.layout = "English (US)"},
+            .networks = {{"wlan0", {.isAlerted = false, .isUp = true, .address = "10.0.0.17"}}},
+            .alerts = {},
+        },
+        RecordedState{
+            .name = "alerted",
+            .displays = {RecordedDisplay(true)},
+            .power = {.IsAlerted = true, .IsPluggedIn = false, .IsCharging = false, .Capacity = 7},
+            .audio = {.Muted = true, .Volume = 0, .PortType = "headphones"},
+            .keyboard = {.layout = "Swedish"},
+            .networks = {{"wlan0", {.isAlerted = true, .isUp = false, .address = ""}}},
+            .alerts = {Alert{.kind = AlertKind::Power,
+                             .priority = AlertPriority::Critical,
+                             .id = "BAT0",
+                             .message = "Battery at 7%"}},
+        },
+    };
+}
+
+static void Publish(ScriptContext& scriptContext, const RecordedState& state) {
+    scriptContext.Publish("displays", state.displays);
+    scriptContext.Publish("power", state.power);
+    scriptContext.Publish("audio", state.audio);
+    scriptContext.Publish("keyboard", state.keyboard);
+    scriptContext.Publish("networks", state.networks);
+    scriptContext.Publish("alerts", state.alerts);
+}
+
+static fs::path FromEnvironment(const char* name) {
+    auto value = std::getenv(name);
+    return value ? fs::path(value) : fs::path();
+}
+
+// Number of pixels where any channel differs more than tolerance, -1 if sizes differ
+static int ComparePng(const fs::path& a, const fs::path& b, int tolerance) {
+    auto surfaceA = cairo_image_surface_create_from_png(a.c_str());
+    auto surfaceB = cairo_image_surface_create_from_png(b.c_str());
+    int differs = -1;
+    if (cairo_surface_status(surfaceA) == CAIRO_STATUS_SUCCESS &&
+        cairo_surface_status(surfaceB) == CAIRO_STATUS_SUCCESS &&
+        cairo_image_surface_get_width(surfaceA) == cairo_image_surface_get_width(surfaceB) &&
+        cairo_image_surface_get_height(surfaceA) == cairo_image_surface_get_height(surfaceB)) {
+        differs = 0;
+        const int cx = cairo_image_surface_get_width(surfaceA);
+        const int cy = cairo_image_surface_get_height(surfaceA);
+        for (int y = 0; y < cy; y++) {
+            auto rowA = cairo_image_surface_get_data(surfaceA) +
+                        y * cairo_image_surface_get_stride(surfaceA);
+            auto rowB = cairo_image_surface_get_data(surfaceB) +
+                        y * cairo_image_surface_get_stride(surfaceB);
+            for (int x = 0; x < cx * 4; x += 4) {
+                for (int c = 0; c < 4; c++) {
+                    if (std::abs(rowA[x + c] - rowB[x + c]) > tolerance) {
+                        differs++;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    cairo_surface_destroy(surfaceA);
+    cairo_surface_destroy(surfaceB);
+    return differs;
+}
+
+TEST_CASE("Render panels from recorded states", "[render]") {
+    const auto configPath = FromEnvironment("ZEN_CONFIG");
+    const auto renderDir = FromEnvironment("ZEN_RENDER_DIR");
+    const auto outputDir = FromEnvironment("ZEN_OUTPUT_DIR");
+    const bool updateGolden = std::getenv("ZEN_UPDATE_GOLDEN") != nullptr;
+    REQUIRE(!configPath.empty());
+    REQUIRE(!renderDir.empty());
+    REQUIRE(!outputDir.empty());
+    const auto goldenDir = renderDir / "golden";
+    if (updateGolden) {
+        fs::create_directories(goldenDir);
+    } else if (!fs::exists(goldenDir)) {
+        // Golden images depend on fonts, generated where those are fixed
+        SKIP("No golden images in " << goldenDir << ", run with ZEN_UPDATE_GOLDEN=1");
+    }
+
+    auto scriptContext = ScriptContext::Create();
+    REQUIRE(scriptContext);
+    // Wrapper fixes the clock and loads configuration from ZEN_CONFIG
+    auto config = scriptContext->Execute((renderDir / "config.lua").c_str());
+    REQUIRE(config);
+    auto bufferPool = BufferPool::CreateInMemory(1, config->bufferWidth, config->bufferHeight);
+    REQUIRE(bufferPool);
+
+    auto panels = config->panels;
+    panels.push_back(config->alertPanel);
+    std::ofstream timings(outputDir / "render-timings.csv");
+    timings << "state,panel,first_us,mean_us,min_us,max_us\n";
+    for (const auto& state : RecordedStates()) {
+        Publish(*scriptContext, state);
+        for (const auto& panelConfig : panels) {
+            const auto name = fmt::format("{}-panel{}", state.name, panelConfig.index);
+            auto surface = HeadlessSurface::Create(panelConfig);
+            // Time the first frame separately, it populates the layout cache
+            using Clock = std::chrono::steady_clock;
+            auto start = Clock::now();
+            surface->Draw(*bufferPool, OUTPUT_NAME, {});
+            auto first = Clock::now() - start;
+            if (!surface->IsDrawn()) {
+                WARN(name << " draws nothing");
+                continue;
+            }
+            auto total = Clock::duration::zero();
+            auto min = Clock::duration::max();
+            auto max = Clock::duration::zero();
+            for (int i = 0; i < TIMED_FRAMES; i++) {
+                start = Clock::now();
+                surface->Draw(*bufferPool, OUTPUT_NAME, {});
+                auto elapsed = Clock::now() - start;
+                total += elapsed;
+                min = std::min(min, elapsed);
+                max = std::max(max, elapsed);
+            }
+            auto us = [](auto d) {
+                return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+            };
+            timings << state.name << "," << panelConfig.index << "," << us(first) << ","
+                    << us(total / TIMED_FRAMES) << "," << us(min) << "," << us(max) << "\n";
+            // Nothing dirty, every widget is reused and the result is the same
+            const auto reused = Metrics::Shared().Get("draw.widgets_reused");
+            surface->Draw(*bufferPool, OUTPUT_NAME,
+                          std::vector<bool>(panelConfig.widgets.size(), false));
+            REQUIRE(surface->IsDrawn());
+            CHECK(Metrics::Shared().Get("draw.widgets_reused") - reused ==
+                  (int64_t)panelConfig.widgets.size());
+            // Dirty draw skipped on this surface, nothing is reused
+            surface->Invalidate();
+            const auto numRendered = Metrics::Shared().Get("draw.widgets_rendered");
+            surface->Draw(*bufferPool, OUTPUT_NAME,
+                          std::vector<bool>(panelConfig.widgets.size(), false));
+            CHECK(Metrics::Shared().Get("draw.widgets_rendered") - numRendered ==
+                  (int64_t)panelConfig.widgets.size());
+
+            const auto rendered = outputDir / (name + ".png");
+            REQUIRE(surface->WritePng(rendered));
+            const auto golden = goldenDir / (name + ".png");
+            if (updateGolden) {
+                fs::copy_file(rendered, golden, fs::copy_options::overwrite_existing);
+                continue;
+            }
+            if (!fs::exists(golden)) {
+                FAIL("No golden image " << golden << ", run with ZEN_UPDATE_GOLDEN=1");
+            }
+            // Allow minor differences caused by antialiasing
+            INFO("Rendered " << rendered << " differs from " << golden);
+            CHECK(ComparePng(rendered, golden, 2) == 0);
+        }
+    }
+    // Render functions are profiled
+    auto stats = ScriptStats::Shared().Snapshot();
+    auto render = std::find_if(stats.begin(), stats.end(),
+                               [](const auto& call) { return call.name.ends_with(".render"); });
+    REQUIRE(render != stats.end());
+    CHECK(render->calls > 0);
+    CHECK(render->time > std::chrono::nanoseconds(0));
+}
+
+TEST_CASE("Frame budget steps quality down and up", "[render]") {
+    using std::chrono::microseconds;
+    const auto budget = microseconds(1000);
+    FrameBudget frameBudget;
+    // Single slow frames are tolerated
+    REQUIRE_FALSE(frameBudget.Record(microseconds(2000), budget));
+    REQUIRE_FALSE(frameBudget.Record(microseconds(500), budget));
+    REQUIRE(frameBudget.quality == Quality::Full);
+    // Consecutive slow frames steps down one level at a time
+    int changes = 0;
+    for (int i = 0; i < 100; i++) {
+        changes += frameBudget.Record(microseconds(2000), budget);
+    }
+    REQUIRE(frameBudget.quality == Quality::StaleWidgets);
+    REQUIRE(changes == 3);
+    // Within budget but without headroom keeps quality
+    for (int i = 0; i < 100; i++) {
+        frameBudget.Record(microseconds(900), budget);
+    }
+    REQUIRE(frameBudget.quality == Quality::StaleWidgets);
+    // Headroom restores
+    for (int i = 0; i < 1000; i++) {
+        frameBudget.Record(microseconds(100), budget);
+    }
+    REQUIRE(frameBudget.quality == Quality::Full);
+    // No budget never degrades
+    FrameBudget unlimited;
+    for (int i = 0; i < 100; i++) {
+        REQUIRE_FALSE(unlimited.Record(microseconds(100000), microseconds(0)));
+    }
+}
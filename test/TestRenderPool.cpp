@@ -0,0 +1,37 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "zen/RenderPool.h"
+
+TEST_CASE("Jobs run once each on distinct workers", "[render-pool]") {
+    auto pool = RenderPool::Create(4);
+    REQUIRE(pool);
+    REQUIRE(pool->NumWorkers() == 4);
+    std::mutex mutex;
+    for (int batch = 0; batch < 20; batch++) {
+        std::vector<int> runs(16);
+        std::set<int> workers;
+        std::vector<std::function<void()>> jobs;
+        for (size_t i = 0; i < runs.size(); i++) {
+            jobs.push_back([&, i] {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                std::lock_guard<std::mutex> lock(mutex);
+                runs[i]++;
+                workers.insert(RenderPool::CurrentWorker());
+            });
+        }
+        pool->Run(jobs);
+        REQUIRE(runs == std::vector<int>(16, 1));
+        REQUIRE(*workers.rbegin() < 4);
+    }
+    // Not on a pool thread
+    REQUIRE(RenderPool::CurrentWorker() == 0);
+    pool->Run({});
+}
+
+TEST_CASE("Pool needs more than one worker", "[render-pool]") {
+    REQUIRE_FALSE(RenderPool::Create(1));
+}
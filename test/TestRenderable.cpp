@@ -0,0 +1,106 @@
+#include <spdlog/spdlog.h>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <lua.hpp>
+#include <string>
+
+#include "zen/ScriptContext.h"
+
+// Workspace list of 8 workspaces with 4 applications each, 40 boxes in flex containers
+static const char* WORKSPACES = R"(
+local workspaces = { type = "flex", direction = "row", items = {} }
+for w = 1, 8 do
+    local items = { {
+        type = "box",
+        markup = "<b>" .. w .. "</b>",
+        color = "#8ec07cff",
+        radius = 5,
+        border = { color = "#282828ff", width = 1 },
+        padding = { left = 4, right = 4 },
+        tag = "workspace" .. w,
+    } }
+    for a = 1, 4 do
+        items[#items + 1] = {
+            type = "box",
+            markup = "application " .. a,
+            color = "#3c3836ff",
+            padding = { left = 2, right = 2, top = 1, bottom = 1 },
+            max_width = 120,
+            ellipsize = "middle",
+            tag = "application" .. a,
+        }
+    end
+    workspaces.items[w] =
+        { type = "flex", direction = "column", items = items, padding = { top = 2 } }
+end
+return workspaces
+)";
+
+// Structure, properties and markup strings
+static std::string Describe(const Renderable* renderable) {
+    if (!renderable) {
+        return "null";
+    }
+    if (auto flex = dynamic_cast<const FlexContainer*>(renderable)) {
+        auto s = fmt::format("flex({},{},{},{})[", flex->isColumn, flex->padding.left,
+                             flex->padding.top, flex->tag);
+        for (const auto& child : flex->children) {
+            s += Describe(child.get()) + ",";
+        }
+        return s + "]";
+    }
+    if (auto box = dynamic_cast<const MarkupBox*>(renderable)) {
+        return fmt::format("box({},{},{},{},{},{},{},{},{},{},{},{})", box->markup.String(),
+                           box->color.r, box->color.a, box->radius, box->border.width,
+                           box->border.color.g, box->padding.left, box->padding.bottom,
+                           box->bounds.maxWidth, (int)box->bounds.ellipsize, box->tag,
+                           box->markup.bounds.maxWidth);
+    }
+    if (auto thumbnail = dynamic_cast<const Thumbnail*>(renderable)) {
+        return fmt::format("thumbnail({},{},{},{},{})", thumbnail->output, thumbnail->workspace,
+                           thumbnail->width, thumbnail->radius, thumbnail->tag);
+    }
+    if (auto markup = dynamic_cast<const Markup*>(renderable)) {
+        return fmt::format("markup({},{},{})", markup->String(), markup->bounds.maxHeight,
+                           (int)markup->bounds.ellipsize);
+    }
+    return "renderable";
+}
+
+// Converts the result of chunk both ways
+static void RequireSame(lua_State* L, const char* chunk) {
+    INFO(chunk);
+    REQUIRE(luaL_dostring(L, chunk) == 0);
+    const auto converted = Describe(RenderableFromLua(L, -1).get());
+    REQUIRE(converted == Describe(RenderableFromLuaLookups(L, -1).get()));
+    lua_pop(L, 1);
+}
+
+TEST_CASE("Render tables are converted the same in one pass", "[renderable]") {
+    auto L = luaL_newstate();
+    luaL_openlibs(L);
+    RequireSame(L, WORKSPACES);
+    RequireSame(L, "return 'markup'");
+    RequireSame(L, "return { type = 'markup', markup = 'a', max_height = 20 }");
+    RequireSame(L, "return { type = 'flex', direction = 'diagonal', items = { 'a' } }");
+    RequireSame(L, "return { type = 'flex', items = { 'a', 1, { type = 'box' } } }");
+    // Fractions are read like sol2 reads ints, never truncated
+    RequireSame(L, "return { type = 'box', radius = 2.6, padding = { left = 1.5 } }");
+    RequireSame(L, "return { type = 'markup', markup = 'a', max_width = 99.5 }");
+    RequireSame(L, "return { type = 'thumbnail', output = 'FAKE-1', workspace = '1', width = 9 }");
+    RequireSame(L, "return { type = 'thumbnail', output = 'FAKE-1' }");
+    RequireSame(L, "return { type = 'unknown' }");
+    // Inherited properties
+    RequireSame(L, "return setmetatable({ type = 'box' }, { __index = { radius = 3 } })");
+    lua_close(L);
+}
+
+TEST_CASE("Render table conversion", "[.][benchmark]") {
+    auto L = luaL_newstate();
+    luaL_openlibs(L);
+    REQUIRE(luaL_dostring(L, WORKSPACES) == 0);
+    BENCHMARK("Lookups") { return RenderableFromLuaLookups(L, -1); };
+    BENCHMARK("One pass") { return RenderableFromLua(L, -1); };
+    lua_close(L);
+}
@@ -0,0 +1,207 @@
+#include <catch2/catch_message.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <thread>
+
+#include "zen/Metrics.h"
+#include "zen/RenderPool.h"
+#include "zen/ScriptContext.h"
+#include "zen/Sources/LuaSource.h"
+
+static Displays TestDisplays() {
+    auto display = Display("FAKE-1");
+    display.isFocused = true;
+    auto code = Workspace("1");
+    code.isFocused = true;
+    code.isVisible = true;
+    code.applications.push_back(
+        Application{.name = "vim", .appId = "Alacritty", .isFocused = true, .isAlerted = false});
+    code.applications.push_back(
+        Application{.name = "htop", .appId = "Alacritty", .isFocused = false, .isAlerted = true});
+    display.workspaces.push_back(std::move(code));
+    display.workspaces.push_back(Workspace("2"));
+    return {display};
+}
+
+static Networks TestNetworks() {
+    return {{"eth0", {.isAlerted = false, .isUp = false, .address = ""}},
+            {"wlan0", {.isAlerted = false, .isUp = true, .address = "10.0.0.17"}}};
+}
+
+static std::filesystem::path ScriptPath(const char* name) {
+    const auto scripts = std::getenv("ZEN_SCRIPTS_DIR");
+    REQUIRE(scripts);
+    return std::filesystem::path(scripts) / name;
+}
+
+struct LoadedScript {
+    std::unique_ptr<ScriptContext> scriptContext;
+    std::shared_ptr<Configuration> config;
+};
+
+// Executes the test script, attached to the main loop and timers when given
+static LoadedScript LoadScript(const char* name, std::shared_ptr<MainLoop> mainLoop = nullptr,
+                               std::shared_ptr<Timers> timers = nullptr) {
+    auto scriptContext = ScriptContext::Create();
+    REQUIRE(scriptContext);
+    if (mainLoop) {
+        scriptContext->Attach(mainLoop, timers);
+    }
+    auto config = scriptContext->Execute(ScriptPath(name).c_str());
+    REQUIRE(config);
+    return {std::move(scriptContext), std::move(config)};
+}
+
+TEST_CASE("Sources read the same as tables and lazily", "[script]") {
+    for (auto lazy : {"0", "1"}) {
+        INFO("Lazy " << lazy);
+        setenv("ZEN_LAZY_SOURCES", lazy, 1);
+        auto [scriptContext, config] = LoadScript("sources.lua");
+        REQUIRE(config->panels.size() == 1);
+        const auto& widget = config->panels[0].widgets.at(0);
+        scriptContext->Publish("displays", TestDisplays());
+        scriptContext->Publish("networks", TestNetworks());
+        REQUIRE(widget.render("FAKE-1"));
+        // Reads the latest state
+        scriptContext->Publish("displays", Displays{});
+        REQUIRE_FALSE(widget.render("FAKE-1"));
+        scriptContext->Publish("displays", TestDisplays());
+        REQUIRE(widget.render("FAKE-1"));
+    }
+}
+
+TEST_CASE("Cached results are computed again when dependencies change", "[script]") {
+    auto [scriptContext, config] = LoadScript("cache.lua");
+    const auto& widget = config->panels.at(0).widgets.at(0);
+    auto power = PowerState{.IsAlerted = false, .IsPluggedIn = false, .IsCharging = false,
+                            .Capacity = 64};
+    scriptContext->Publish("power", power);
+    REQUIRE(widget.render("1,1"));
+    REQUIRE(widget.render("1,1"));
+    // Field unchanged, source published
+    power.IsCharging = true;
+    scriptContext->Publish("power", power);
+    REQUIRE(widget.render("1,2"));
+    power.Capacity = 65;
+    scriptContext->Publish("power", power);
+    REQUIRE(widget.render("2,3"));
+}
+
+TEST_CASE("Measured markup is shaped once", "[script]") {
+    auto [scriptContext, config] = LoadScript("measure.lua");
+    const auto& widget = config->panels.at(0).widgets.at(0);
+    REQUIRE(widget.render("FAKE-1"));
+    // Everything measured again is found in the layout cache
+    const auto misses = Metrics::Shared().Get("layout.misses");
+    REQUIRE(widget.render("FAKE-1"));
+    REQUIRE(Metrics::Shared().Get("layout.misses") == misses);
+}
+
+TEST_CASE("Files are read through the file cache", "[script]") {
+    auto [scriptContext, config] = LoadScript("fs.lua");
+    const auto& widget = config->panels.at(0).widgets.at(0);
+    REQUIRE(widget.render("FAKE-1"));
+    // Read again from the cache
+    const auto misses = Metrics::Shared().Get("fs.misses");
+    REQUIRE(widget.render("FAKE-1"));
+    REQUIRE(Metrics::Shared().Get("fs.misses") == misses);
+}
+
+TEST_CASE("Boxes are styled by handles", "[script]") {
+    auto [scriptContext, config] = LoadScript("style.lua");
+    auto rendered = config->panels.at(0).widgets.at(0).render("FAKE-1");
+    auto box = dynamic_cast<MarkupBox*>(rendered.get());
+    REQUIRE(box);
+    REQUIRE(box->color.r == 1.0);
+    REQUIRE(box->radius == 5);
+    REQUIRE(box->border.width == 2);
+    REQUIRE(box->border.color.g == 1.0);
+    REQUIRE(box->padding.left == 3);
+}
+
+TEST_CASE("Timers run Lua functions until cancelled", "[script]") {
+    auto mainLoop = std::shared_ptr<MainLoop>(MainLoop::Create());
+    auto timers = Timers::Create(mainLoop);
+    REQUIRE(timers);
+    auto [scriptContext, config] = LoadScript("timers.lua", mainLoop, timers);
+    // Hidden, only the timer always running runs
+    for (int i = 0; i < 2; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+        REQUIRE(timers->OnRead());
+    }
+    REQUIRE(config->panels.at(0).widgets.at(0).render("FAKE-1"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(15));
+    REQUIRE_FALSE(timers->OnRead());
+}
+
+TEST_CASE("Widgets are drawn again when their render function is no longer skipped",
+          "[script]") {
+    auto mainLoop = std::shared_ptr<MainLoop>(MainLoop::Create());
+    auto timers = Timers::Create(mainLoop);
+    REQUIRE(timers);
+    auto [scriptContext, config] = LoadScript("backoff.lua", mainLoop, timers);
+    const auto& widget = config->panels.at(0).widgets.at(0);
+    REQUIRE_FALSE(widget.isBackedOff());
+    // Aborted and then skipped, dirty until rendered again
+    REQUIRE(widget.render("FAKE-1"));
+    REQUIRE(widget.isBackedOff());
+    REQUIRE(widget.render("FAKE-1"));
+    REQUIRE(widget.isBackedOff());
+    // Woken up when skipping ends after a second
+    std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+    REQUIRE(timers->OnRead());
+    REQUIRE(widget.render("FAKE-1"));
+    REQUIRE_FALSE(widget.isBackedOff());
+}
+
+TEST_CASE("Render workers call their own Lua state", "[script]") {
+    auto [scriptContext, config] = LoadScript("workers.lua");
+    REQUIRE(config->renderWorkers == 3);
+    auto pool = RenderPool::Create(config->renderWorkers);
+    REQUIRE(pool);
+    scriptContext->Publish("power", PowerState{.IsAlerted = false, .IsPluggedIn = false,
+                                               .IsCharging = false, .Capacity = 64});
+    const auto& widget = config->panels.at(0).widgets.at(0);
+    std::vector<std::unique_ptr<Renderable>> rendered(12);
+    std::vector<std::function<void()>> jobs;
+    for (auto& renderable : rendered) {
+        jobs.push_back([&widget, target = &renderable] { *target = widget.render("FAKE-1"); });
+    }
+    pool->Run(jobs);
+    for (const auto& renderable : rendered) {
+        REQUIRE(renderable);
+    }
+}
+
+TEST_CASE("Sources defined in configuration are polled in a state of their own", "[script]") {
+    const auto path = ScriptPath("poll.lua");
+    auto [scriptContext, config] = LoadScript("poll.lua");
+    REQUIRE(config->luaSources.at("counter") == std::chrono::milliseconds(100));
+    auto poller = SourcePoller::Create(path.c_str(), "counter");
+    REQUIRE(poller);
+    auto first = poller->Poll();
+    REQUIRE(first);
+    auto second = poller->Poll();
+    REQUIRE(second);
+    REQUIRE(*first != *second);
+    scriptContext->Publish("counter", *second);
+    REQUIRE(config->panels.at(0).widgets.at(0).render("FAKE-1"));
+    REQUIRE_FALSE(SourcePoller::Create(path.c_str(), "missing"));
+}
+
+TEST_CASE("Polled sources are published once polled", "[script]") {
+    const auto path = ScriptPath("poll.lua");
+    auto [scriptContext, config] = LoadScript("poll.lua");
+    std::shared_ptr<MainLoop> mainLoop = MainLoop::Create();
+    auto source = LuaSource::Create(mainLoop, path, "counter", std::chrono::milliseconds(10));
+    // Dirty when published after the first poll returned, the render function fails on nil
+    for (int i = 0; i < 500 && source->IsDrawn(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        source->Publish("counter", *scriptContext);
+    }
+    REQUIRE_FALSE(source->IsDrawn());
+    REQUIRE(config->panels.at(0).widgets.at(0).render("FAKE-1"));
+    // Stops and waits for the polling thread
+    source = nullptr;
+}
@@ -0,0 +1,67 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "zen/Template.h"
+
+using namespace Expressions;
+
+static std::string Evaluate(const Expression& expression, const BoundValues& values) {
+    return ToString(expression(values));
+}
+
+TEST_CASE("Format applies specs to bound values", "[template]") {
+    BoundValues values;
+    values.Set("power.capacity", 63.6);
+    values.Set("audio.port", std::string("speaker"));
+    auto format = Format("{:.0f}% {{{}}}", {Bind("power.capacity"), Bind("audio.port")});
+    REQUIRE(format);
+    REQUIRE(Evaluate(format, values) == "64% {speaker}");
+    // Updated values are picked up without recompiling
+    values.Set("power.capacity", 7.0);
+    REQUIRE(Evaluate(format, values) == "7% {speaker}");
+    // Missing values are formatted as empty
+    REQUIRE(Evaluate(Format("[{}]", {Bind("missing")}), values) == "[]");
+}
+
+TEST_CASE("Invalid formats are rejected", "[template]") {
+    REQUIRE_FALSE(Format("{", {Literal(1.0)}));
+    REQUIRE_FALSE(Format("}", {}));
+    REQUIRE_FALSE(Format("{} {}", {Literal(1.0)}));
+}
+
+TEST_CASE("Levels pick first threshold not exceeded", "[template]") {
+    BoundValues values;
+    auto levels = Levels(Bind("power.capacity"),
+                         {{50, Literal(std::string("half"))}, {10, Literal(std::string("low"))}},
+                         Literal(std::string("full")));
+    values.Set("power.capacity", 5.0);
+    REQUIRE(Evaluate(levels, values) == "low");
+    values.Set("power.capacity", 10.0);
+    REQUIRE(Evaluate(levels, values) == "low");
+    values.Set("power.capacity", 42.0);
+    REQUIRE(Evaluate(levels, values) == "half");
+    values.Set("power.capacity", 90.0);
+    REQUIRE(Evaluate(levels, values) == "full");
+    // Not a number
+    values.Set("power.capacity", std::string("?"));
+    REQUIRE(Evaluate(levels, values) == "full");
+}
+
+TEST_CASE("Map matches values as strings", "[template]") {
+    BoundValues values;
+    auto map = Map(Bind("audio.muted"), {{"true", Literal(std::string("muted"))}}, nullptr);
+    values.Set("audio.muted", true);
+    REQUIRE(Evaluate(map, values) == "muted");
+    values.Set("audio.muted", false);
+    REQUIRE(std::holds_alternative<std::monostate>(map(values)));
+}
+
+TEST_CASE("Bound values are versioned by change", "[template]") {
+    BoundValues values;
+    REQUIRE(values.Version("power.capacity") == 0);
+    values.Set("power.capacity", 64.0);
+    REQUIRE(values.Version("power.capacity") == 1);
+    values.Set("power.capacity", 64.0);
+    REQUIRE(values.Version("power.capacity") == 1);
+    values.Set("power.capacity", 63.0);
+    REQUIRE(values.Version("power.capacity") == 2);
+}
@@ -0,0 +1,151 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "zen/Downscale.h"
+#include "zen/Sources/ThumbnailSource.h"
+#include "zen/ThumbnailCache.h"
+
+// Produces frames of a horizontal gradient without any compositor. Captures are queued
+// until Complete is called to behave like the asynchronous screencopy.
+class FakeFrameProducer : public FrameProducer {
+   public:
+    FakeFrameProducer(int cx, int cy) : m_cx(cx), m_cy(cy), m_pixels(cx * cy * 4) {
+        for (int y = 0; y < cy; y++) {
+            for (int x = 0; x < cx; x++) {
+                auto pixel = &m_pixels[(y * cx + x) * 4];
+                pixel[0] = x % 256;
+                pixel[1] = y % 256;
+                pixel[2] = 0x80;
+                pixel[3] = 0xff;
+            }
+        }
+    }
+
+    bool Capture(const std::string& outputName, OnFrame onFrame) override {
+        captured.push_back(outputName);
+        m_queued.push_back(std::move(onFrame));
+        return true;
+    }
+
+    void Complete() {
+        auto queued = std::move(m_queued);
+        for (auto& onFrame : queued) {
+            onFrame(Frame{.pixels = m_pixels.data(),
+                          .cx = m_cx,
+                          .cy = m_cy,
+                          .stride = m_cx * 4,
+                          .hasAlpha = false});
+        }
+    }
+
+    std::vector<std::string> captured;
+
+   private:
+    int m_cx;
+    int m_cy;
+    std::vector<uint8_t> m_pixels;
+    std::vector<OnFrame> m_queued;
+};
+
+static std::vector<uint8_t> RandomPixels(int cx, int cy) {
+    std::mt19937 random(17);
+    std::vector<uint8_t> pixels(cx * cy * 4);
+    for (auto& b : pixels) {
+        b = random() & 0xff;
+    }
+    return pixels;
+}
+
+TEST_CASE("Box downscale averages blocks", "[thumbnail]") {
+    // 2x2 block of a single channel value, rest zero
+    std::vector<uint8_t> src = {10, 0, 0, 0, 20, 0, 0, 0, 30, 0, 0, 0, 41, 0, 0, 0};
+    std::vector<uint8_t> dst(4);
+    BoxDownscale(src.data(), 2, 2, 8, 2, dst.data(), 4);
+    // (10 + 20 + 30 + 41) / 4 = 25.25
+    REQUIRE(dst[0] == 25);
+    REQUIRE(dst[1] == 0);
+}
+
+TEST_CASE("Vectorized downscale matches scalar", "[thumbnail]") {
+    for (int factor : {1, 2, 3, 4, 5, 8, 9}) {
+        const int cx = 37 * factor + 3, cy = 5 * factor + 2;
+        auto src = RandomPixels(cx, cy);
+        const int dstCx = cx / factor, dstCy = cy / factor;
+        std::vector<uint8_t> vectorized(dstCx * dstCy * 4), scalar(dstCx * dstCy * 4);
+        BoxDownscale(src.data(), cx, cy, cx * 4, factor, vectorized.data(), dstCx * 4);
+        BoxDownscaleScalar(src.data(), cx, cy, cx * 4, factor, scalar.data(), dstCx * 4);
+        REQUIRE(vectorized == scalar);
+    }
+}
+
+TEST_CASE("Downscale bottom up frame", "[thumbnail]") {
+    const int cx = 16, cy = 8;
+    auto src = RandomPixels(cx, cy);
+    // Flip rows and downscale with negative stride, should match the original
+    std::vector<uint8_t> flipped(src.size());
+    for (int y = 0; y < cy; y++) {
+        memcpy(&flipped[y * cx * 4], &src[(cy - 1 - y) * cx * 4], cx * 4);
+    }
+    std::vector<uint8_t> expected(cx / 4 * cy / 4 * 4), actual(expected.size());
+    BoxDownscale(src.data(), cx, cy, cx * 4, 4, expected.data(), cx);
+    BoxDownscale(flipped.data() + (cy - 1) * cx * 4, cx, cy, -cx * 4, 4, actual.data(), cx);
+    REQUIRE(expected == actual);
+}
+
+static Displays TestDisplays(const std::string& visible) {
+    auto display = Display("FAKE-1");
+    for (auto name : {"1", "2"}) {
+        auto workspace = Workspace(name);
+        workspace.isVisible = workspace.name == visible;
+        display.workspaces.push_back(std::move(workspace));
+    }
+    return {display};
+}
+
+TEST_CASE("Thumbnails captured on change", "[thumbnail]") {
+    ThumbnailCache::Shared().Clear();
+    std::shared_ptr<MainLoop> mainLoop = MainLoop::Create();
+    auto producer = std::make_shared<FakeFrameProducer>(1920, 1080);
+    auto source = ThumbnailSource::Create(mainLoop, producer);
+
+    source->Update(TestDisplays("1"));
+    REQUIRE(producer->captured.size() == 1);
+    // Capture in flight, not captured again
+    source->Update(TestDisplays("1"));
+    REQUIRE(producer->captured.size() == 1);
+    producer->Complete();
+    auto thumbnail = ThumbnailCache::Shared().Lookup("FAKE-1", "1");
+    REQUIRE(thumbnail);
+    // Factor 4 fits 480 wide
+    REQUIRE(thumbnail->cx == 480);
+    REQUIRE(thumbnail->cy == 270);
+    REQUIRE_FALSE(ThumbnailCache::Shared().Lookup("FAKE-1", "2"));
+
+    SECTION("Deferred while overlay is visible") {
+        const auto captures = producer->captured.size();
+        source->SetVisible(true);
+        REQUIRE(producer->captured.size() == captures);
+        source->Update(TestDisplays("2"));
+        REQUIRE(producer->captured.size() == captures);
+        source->SetVisible(false);
+        REQUIRE(producer->captured.size() == captures + 1);
+        producer->Complete();
+        REQUIRE(ThumbnailCache::Shared().Lookup("FAKE-1", "2"));
+    }
+
+    SECTION("Captures completing while overlay is visible are dropped") {
+        source->Update(TestDisplays("2"));
+        source->SetVisible(true);
+        producer->Complete();
+        REQUIRE_FALSE(ThumbnailCache::Shared().Lookup("FAKE-1", "2"));
+    }
+
+    SECTION("Removed workspaces are dropped") {
+        auto displays = TestDisplays("2");
+        displays[0].workspaces.erase(displays[0].workspaces.begin());
+        source->Update(displays);
+        REQUIRE_FALSE(ThumbnailCache::Shared().Lookup("FAKE-1", "1"));
+    }
+}
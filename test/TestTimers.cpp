@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <thread>
+
+#include "zen/Timers.h"
+
+using std::chrono::milliseconds;
+
+TEST_CASE("Timers due together run in one wakeup", "[timers]") {
+    auto mainLoop = std::shared_ptr<MainLoop>(MainLoop::Create());
+    auto timers = Timers::Create(mainLoop);
+    REQUIRE(timers);
+    int runs = 0;
+    timers->SetOnRun([&runs]() { runs++; });
+    int first = 0;
+    int second = 0;
+    timers->Start(milliseconds(10), milliseconds(0), true, [&first]() {
+        first++;
+        return true;
+    });
+    timers->Start(milliseconds(20), milliseconds(20), true, [&second]() {
+        second++;
+        return true;
+    });
+    REQUIRE_FALSE(timers->OnRead());
+    std::this_thread::sleep_for(milliseconds(30));
+    REQUIRE(timers->OnRead());
+    REQUIRE(runs == 1);
+    REQUIRE(first == 1);
+    REQUIRE(second == 1);
+    // Once only
+    std::this_thread::sleep_for(milliseconds(30));
+    REQUIRE(timers->OnRead());
+    REQUIRE(first == 1);
+    REQUIRE(second == 2);
+}
+
+TEST_CASE("Timers are suspended while hidden and can be cancelled", "[timers]") {
+    auto mainLoop = std::shared_ptr<MainLoop>(MainLoop::Create());
+    auto timers = Timers::Create(mainLoop);
+    REQUIRE(timers);
+    int hidden = 0;
+    int always = 0;
+    timers->Start(milliseconds(5), milliseconds(5), false, [&hidden]() {
+        hidden++;
+        return true;
+    });
+    const auto id = timers->Start(milliseconds(5), milliseconds(5), true, [&always]() {
+        always++;
+        return true;
+    });
+    std::this_thread::sleep_for(milliseconds(20));
+    timers->OnRead();
+    REQUIRE(hidden == 0);
+    REQUIRE(always == 1);
+    // Due while hidden runs once when shown
+    timers->SetVisible(true);
+    timers->Cancel(id);
+    timers->OnRead();
+    REQUIRE(hidden == 1);
+    REQUIRE(always == 1);
+    // Stopped by returning false
+    int stopping = 0;
+    timers->Start(milliseconds(0), milliseconds(1), true, [&stopping]() {
+        stopping++;
+        return false;
+    });
+    std::this_thread::sleep_for(milliseconds(10));
+    timers->OnRead();
+    timers->OnRead();
+    REQUIRE(stopping == 1);
+}
@@ -0,0 +1,32 @@
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+
+#include "zen/util.h"
+
+TEST_CASE("Html escaping replaces special characters", "[util]") {
+    REQUIRE(Util::HtmlEscape("") == "");
+    REQUIRE(Util::HtmlEscape("plain") == "plain");
+    REQUIRE(Util::HtmlEscape("<b>\"Tom\" & 'Jerry'</b>") ==
+            "&lt;b&gt;&quot;Tom&quot; &amp; &apos;Jerry&apos;&lt;/b&gt;");
+    // Special characters on both sides of 16 byte blocks
+    REQUIRE(Util::HtmlEscape("0123456789abcde&f0123456789abcde<") ==
+            "0123456789abcde&amp;f0123456789abcde&lt;");
+    std::string out = "kept ";
+    Util::AppendHtmlEscaped(out, "a&b");
+    REQUIRE(out == "kept a&amp;b");
+}
+
+TEST_CASE("Vectorized escaping matches scalar", "[util]") {
+    std::mt19937 random(42);
+    const std::string alphabet = "abc &<>\"'\xc3\xa5";
+    for (size_t length = 0; length < 100; length++) {
+        std::string s;
+        for (size_t i = 0; i < length; i++) {
+            s += alphabet[random() % alphabet.size()];
+        }
+        std::string vectorized, scalar;
+        Util::AppendHtmlEscaped(vectorized, s);
+        Util::AppendHtmlEscapedScalar(scalar, s);
+        REQUIRE(vectorized == scalar);
+    }
+}
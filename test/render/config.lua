@@ -0,0 +1,13 @@
+-- Loads the configuration under test with a fixed clock to make rendering
+-- reproducible.
+local fixed = os.time({ year = 2024, month = 3, day = 14, hour = 13, min = 37, sec = 0 })
+local time = os.time
+local date = os.date
+os.time = function(t)
+    if t then return time(t) end
+    return fixed
+end
+os.date = function(format, t)
+    return date(format, t or fixed)
+end
+return dofile(os.getenv("ZEN_CONFIG"))
@@ -0,0 +1,15 @@
+-- Loops on the first call until aborted by the watchdog, rendered once backed off.
+local calls = 0
+local function loop()
+    calls = calls + 1
+    while calls == 1 do
+    end
+    return "ok"
+end
+
+return {
+    callback_budget = 10,
+    panels = {
+        { widgets = { { on_render = loop } } },
+    },
+}
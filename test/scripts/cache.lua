@@ -0,0 +1,22 @@
+-- Counts how many times cached functions are computed, the render function fails
+-- unless the counts match the expected counts passed as output name.
+local computed = { capacity = 0, power = 0 }
+
+local function check(expected)
+    local capacity = zen.cache("capacity", { "power.capacity" }, function()
+        computed.capacity = computed.capacity + 1
+        return zen.power.capacity
+    end)
+    assert(capacity == zen.power.capacity)
+    zen.cache("power", { "power" }, function()
+        computed.power = computed.power + 1
+    end)
+    assert(computed.capacity .. "," .. computed.power == expected)
+    return "ok"
+end
+
+return {
+    panels = {
+        { widgets = { { sources = { "power" }, on_render = check } } },
+    },
+}
@@ -0,0 +1,21 @@
+-- Reads a file through zen.fs, the render function fails unless it is read as written.
+local path = os.tmpname()
+local file = assert(io.open(path, "w"))
+file:write("up\nwg0\n")
+file:close()
+
+local function check()
+    assert(zen.fs.read(path) == "up\nwg0\n")
+    local lines = zen.fs.lines(path)
+    assert(#lines == 2 and lines[1] == "up" and lines[2] == "wg0")
+    -- Same table until the file changes
+    assert(zen.fs.lines(path) == lines)
+    assert(zen.fs.read(path .. ".missing") == nil)
+    return "ok"
+end
+
+return {
+    panels = {
+        { widgets = { { sources = { "files" }, on_render = check } } },
+    },
+}
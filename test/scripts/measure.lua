@@ -0,0 +1,20 @@
+-- Measures markup and runs, the render function fails unless sizes are consistent.
+local function check()
+    local width, height, baseline = zen.measure("zen")
+    assert(width > 0 and height > 0 and baseline > 0 and baseline <= height)
+    assert(zen.measure("zenway") > width)
+    -- Runs measure the same as the concatenated markup
+    local runs = { zen.measure({ "<b>", "zen", "</b>" }) }
+    local markup = { zen.measure("<b>zen</b>") }
+    assert(runs[1] == markup[1] and runs[2] == markup[2] and runs[3] == markup[3])
+    -- Bounded the same as a markup
+    local bounded = zen.measure("zenway zenway zenway", { max_width = 20 })
+    assert(bounded <= 20)
+    return "ok"
+end
+
+return {
+    panels = {
+        { widgets = { { on_render = check } } },
+    },
+}
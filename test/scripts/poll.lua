@@ -0,0 +1,30 @@
+-- Source defined by a poll function, the render function fails unless the polled value
+-- has been published with integers kept as integers.
+local polls = 0
+
+return {
+    sources = {
+        counter = {
+            interval = 100,
+            poll = function()
+                polls = polls + 1
+                return { count = polls, names = { "a", "b" }, nested = { ok = true } }
+            end,
+        },
+    },
+    panels = {
+        {
+            widgets = {
+                {
+                    sources = { "counter" },
+                    on_render = function()
+                        local counter = zen.counter
+                        assert(math.type == nil or math.type(counter.count) == "integer")
+                        assert(counter.names[2] == "b" and counter.nested.ok)
+                        return { type = "markup", markup = tostring(counter.count) }
+                    end,
+                },
+            },
+        },
+    },
+}
@@ -0,0 +1,53 @@
+-- Reads published sources the way configurations do, the render function
+-- fails when anything is unexpected. Run with lazy_sources set and not.
+local function check()
+    local display = zen.displays["FAKE-1"]
+    assert(display.focus)
+    assert(not display.alert)
+    assert(zen.displays["FAKE-2"] == nil)
+    local displays = 0
+    for name, d in pairs(zen.displays) do
+        assert(name == "FAKE-1")
+        assert(d.focus)
+        displays = displays + 1
+    end
+    assert(displays == 1)
+
+    assert(#display.workspaces == 2)
+    local names = {}
+    for _, workspace in ipairs(display.workspaces) do
+        names[#names + 1] = workspace.name
+    end
+    assert(table.concat(names, ",") == "1,2")
+    local applications = 0
+    for _, workspace in pairs(display.workspaces) do
+        for _, application in pairs(workspace.applications) do
+            applications = applications + 1
+        end
+    end
+    assert(applications == 2)
+    local first = display.workspaces[1]
+    assert(first.focus and first.visible)
+    assert(first.applications[2].name == "htop")
+    assert(first.applications[2].alert)
+    assert(first.applications[1].appid == "Alacritty")
+    assert(display.workspaces[3] == nil)
+    assert(#display.workspaces[2].applications == 0)
+
+    assert(#zen.networks == 2)
+    assert(zen.networks[1].interface == "eth0")
+    assert(not zen.networks[1].up)
+    local up = nil
+    for _, network in pairs(zen.networks) do
+        if network.up then up = network end
+    end
+    assert(up.interface == "wlan0" and up.address == "10.0.0.17")
+    return "ok"
+end
+
+return {
+    lazy_sources = os.getenv("ZEN_LAZY_SOURCES") == "1",
+    panels = {
+        { widgets = { { sources = { "displays", "networks" }, on_render = check } } },
+    },
+}
@@ -0,0 +1,17 @@
+-- Boxes styled by a handle from zen.style, properties in the box table are not looked up.
+local FOCUSED = zen.style({
+    color = "#ff0000ff",
+    radius = 5,
+    border = { color = "#00ff00ff", width = 2 },
+    padding = { left = 3 },
+})
+
+return {
+    panels = {
+        { widgets = { {
+            on_render = function()
+                return { type = "box", markup = "1", style = FOCUSED, radius = 1 }
+            end,
+        } } },
+    },
+}
@@ -0,0 +1,17 @@
+-- Counts ticks of a timer, the render function fails unless it has run twice and the
+-- timer suspended while hidden has not run at all.
+local ticks = 0
+local every = zen.every(10, function() ticks = ticks + 1 end, { always = true })
+zen.after(10, function() ticks = ticks + 100 end)
+
+local function check()
+    assert(ticks == 2, ticks)
+    every:cancel()
+    return "ok"
+end
+
+return {
+    panels = {
+        { widgets = { { sources = { "timers" }, on_render = check } } },
+    },
+}
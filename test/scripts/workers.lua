@@ -0,0 +1,16 @@
+-- Rendered in a Lua state per render worker, every state is published the sources.
+return {
+    render_workers = 3,
+    panels = {
+        {
+            widgets = {
+                {
+                    sources = { "power" },
+                    on_render = function()
+                        return { type = "markup", markup = tostring(zen.power.capacity) }
+                    end,
+                },
+            },
+        },
+    },
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+enum class AlertKind { Power, Network, Window };
+
+enum class AlertPriority { Low, Normal, High, Critical };
+
+struct Alert {
+    AlertKind kind;
+    AlertPriority priority;
+    std::string id;       // Identifies the alert within kind, battery, interface or window
+    std::string message;  // Human readable payload
+
+    bool operator==(const Alert& other) const = default;
+};
+
+using Alerts = std::vector<Alert>;
+
+// Raised or cleared alert posted by a source
+struct AlertEvent {
+    bool isRaised;
+    Alert alert;
+};
@@ -29,14 +29,18 @@ std::unique_ptr<Buffer> Buffer::Create(wl_buffer *wlbuffer, void *address, int c
     buffer->m_cr_surface = cairo_image_surface_create_for_data((uint8_t *)address,
                                                                CAIRO_FORMAT_ARGB32, cx, cy, stride);
     buffer->m_cr = cairo_create(const_cast<cairo_surface_t *>(buffer->m_cr_surface));
-    wl_buffer_add_listener(wlbuffer, &listener, buffer.get());
+    if (wlbuffer) {
+        wl_buffer_add_listener(wlbuffer, &listener, buffer.get());
+    }
     return buffer;
 }
 
 Buffer::~Buffer() {
-    cairo_surface_destroy(const_cast<cairo_surface_t *>(m_cr_surface));
     cairo_destroy(m_cr);
-    wl_buffer_destroy(m_wlbuffer);
+    cairo_surface_destroy(const_cast<cairo_surface_t *>(m_cr_surface));
+    if (m_wlbuffer) {
+        wl_buffer_destroy(m_wlbuffer);
+    }
 }
 
 void Buffer::Clear(uint8_t v) { memset(const_cast<void *>(m_address), v, m_sizeInBytes); }
@@ -81,6 +85,16 @@ std::unique_ptr<BufferPool> BufferPool::Create(wl_shm &shm, const int n, const i
     return std::unique_ptr<BufferPool>(new BufferPool(std::move(buffers)));
 }
 
+std::unique_ptr<BufferPool> BufferPool::CreateInMemory(const int n, const int cx, const int cy) {
+    const size_t size = cy * cx * 4;
+    auto memory = std::make_unique<uint8_t[]>(size * n);
+    Buffers buffers(n);
+    for (int i = 0; i < n; i++) {
+        buffers[i] = Buffer::Create(nullptr, memory.get() + (size * i), cx, cy);
+    }
+    return std::unique_ptr<BufferPool>(new BufferPool(std::move(buffers), std::move(memory)));
+}
+
 // As long as only one thread is running this is ok
 std::shared_ptr<Buffer> BufferPool::Get() {
     for (auto &buffer : m_buffers) {
@@ -6,18 +6,21 @@
 #include <memory>
 #include <vector>
 
-// Represents a single buffer used for rendering
+// Represents a single buffer used for rendering. The wl_buffer is null when the buffer
+// is only backed by memory (headless rendering).
 class Buffer {
    public:
     static std::unique_ptr<Buffer> Create(wl_buffer *buffer, void *address, int cx, int cy);
     virtual ~Buffer();
     void OnRelease();
     wl_buffer *Lock() {
-        m_inUse = true;
+        // Memory backed buffers are never handed over to a compositor
+        m_inUse = m_wlbuffer != nullptr;
         return m_wlbuffer;
     }
 
     cairo_t *GetCairoCtx() { return m_cr; }
+    cairo_surface_t *GetCairoSurface() { return const_cast<cairo_surface_t *>(m_cr_surface); }
     void Clear(uint8_t v);
     bool InUse() { return m_inUse; }
 
@@ -38,11 +41,15 @@ class Buffer {
 class BufferPool {
    public:
     static std::unique_ptr<BufferPool> Create(wl_shm &shm, const int n, const int cx, const int cy);
+    // Buffers in plain memory without any compositor, used for headless rendering
+    static std::unique_ptr<BufferPool> CreateInMemory(const int n, const int cx, const int cy);
     std::shared_ptr<Buffer> Get();
 
    private:
     using Buffers = std::vector<std::shared_ptr<Buffer>>;
 
-    BufferPool(Buffers &&buffers) : m_buffers(buffers) {}
+    BufferPool(Buffers &&buffers, std::unique_ptr<uint8_t[]> memory = nullptr)
+        : m_buffers(buffers), m_memory(std::move(memory)) {}
     Buffers m_buffers;
+    std::unique_ptr<uint8_t[]> m_memory;  // Only set when not backed by shared memory
 };
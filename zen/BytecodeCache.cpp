@@ -0,0 +1,188 @@
+#include "zen/BytecodeCache.h"
+
+#include <spdlog/spdlog.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <lua.hpp>
+#include <sstream>
+#ifdef ZEN_LUAJIT
+#include <luajit.h>
+#endif
+
+#include "zen/Metrics.h"
+
+#ifdef ZEN_LUAJIT
+static const char* LUA_IDENTITY = LUAJIT_VERSION;
+#else
+static const char* LUA_IDENTITY = LUA_RELEASE;
+#endif
+
+// Written first in each entry, source is compiled again when anything differs
+struct EntryHeader {
+    char version[32];
+    int64_t mtime;
+    uint64_t hash;
+};
+
+// FNV-1a, stable across runs and builds
+static uint64_t Hash(std::string_view s) {
+    uint64_t hash = 14695981039346656037ull;
+    for (auto c : s) {
+        hash = (hash ^ (uint8_t)c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static bool ReadFile(const std::filesystem::path& path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    content = stream.str();
+    return true;
+}
+
+static int64_t ModificationTime(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) == -1) {
+        return -1;
+    }
+    return (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+static int Writer(lua_State*, const void* p, size_t size, void* data) {
+    ((std::string*)data)->append((const char*)p, size);
+    return 0;
+}
+
+BytecodeCache& BytecodeCache::Shared() {
+    static BytecodeCache cache([]() {
+        auto xdgCacheHome = std::getenv("XDG_CACHE_HOME");
+        if (xdgCacheHome) {
+            return std::filesystem::path(xdgCacheHome) / "zenway";
+        }
+        auto home = std::getenv("HOME");
+        return home ? std::filesystem::path(home) / ".cache" / "zenway" : std::filesystem::path();
+    }());
+    return cache;
+}
+
+std::filesystem::path BytecodeCache::EntryPath(const std::string& path) const {
+    // Relative paths from package.path depend on working directory
+    const auto key = std::filesystem::absolute(path).string();
+    return m_directory / fmt::format("{:016x}.luac", Hash(key));
+}
+
+int BytecodeCache::Load(lua_State* L, const std::string& path) {
+    const auto chunkName = "@" + path;
+    std::string source;
+    if (!ReadFile(path, source)) {
+        lua_pushfstring(L, "cannot open %s", path.c_str());
+        return LUA_ERRFILE;
+    }
+    // Skip a first line like "#!/usr/bin/lua" as luaL_loadfile does, keeping the newline
+    // so line numbers still match
+    if (source.starts_with('#')) {
+        source.erase(0, source.find('\n'));
+    }
+    if (m_directory.empty()) {
+        return luaL_loadbufferx(L, source.data(), source.size(), chunkName.c_str(), "t");
+    }
+    EntryHeader header{};
+    strncpy(header.version, LUA_IDENTITY, sizeof(header.version) - 1);
+    header.mtime = ModificationTime(path);
+    header.hash = Hash(source);
+    const auto entryPath = EntryPath(path);
+    std::string entry;
+    if (ReadFile(entryPath, entry) && entry.size() > sizeof(EntryHeader) &&
+        memcmp(entry.data(), &header, sizeof(EntryHeader)) == 0) {
+        const auto result =
+            luaL_loadbufferx(L, entry.data() + sizeof(EntryHeader),
+                             entry.size() - sizeof(EntryHeader), chunkName.c_str(), "b");
+        if (result == LUA_OK) {
+            m_hits++;
+            Metrics::Shared().Add("lua.bytecode_hits");
+            return result;
+        }
+        // Corrupt, compile again
+        spdlog::warn("Invalid cached bytecode for {}", path);
+        lua_pop(L, 1);
+    }
+    m_misses++;
+    Metrics::Shared().Add("lua.bytecode_misses");
+    const auto result = luaL_loadbufferx(L, source.data(), source.size(), chunkName.c_str(), "t");
+    if (result != LUA_OK) {
+        return result;
+    }
+    entry.assign((const char*)&header, sizeof(EntryHeader));
+#ifdef ZEN_LUAJIT
+    lua_dump(L, Writer, &entry);
+#else
+    // Keep debug information for line numbers in errors
+    lua_dump(L, Writer, &entry, 0);
+#endif
+    // Write to a temporary file unique to this writer and rename, concurrent starts and
+    // threads never read partial entries
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    auto temporaryPath = entryPath.string() + ".XXXXXX";
+    const auto fd = mkstemp(temporaryPath.data());
+    if (fd == -1) {
+        spdlog::warn("Failed to create bytecode cache {}: {}", temporaryPath, strerror(errno));
+        return result;
+    }
+    const auto written = write(fd, entry.data(), entry.size());
+    close(fd);
+    if (written != (ssize_t)entry.size()) {
+        spdlog::warn("Failed to write bytecode cache {}", temporaryPath);
+        std::filesystem::remove(temporaryPath, error);
+        return result;
+    }
+    std::filesystem::rename(temporaryPath, entryPath, error);
+    if (error) {
+        spdlog::warn("Failed to write bytecode cache {}: {}", entryPath.c_str(), error.message());
+        std::filesystem::remove(temporaryPath, error);
+    }
+    return result;
+}
+
+// Same as the Lua file searcher of require but loads through the cache
+static int CachedSearcher(lua_State* L) {
+    auto cache = (BytecodeCache*)lua_touserdata(L, lua_upvalueindex(1));
+    const auto name = luaL_checkstring(L, 1);
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchpath");
+    lua_pushstring(L, name);
+    lua_getfield(L, -3, "path");
+    lua_call(L, 2, 2);
+    if (lua_isnil(L, -2)) {
+        // Message listing the paths tried
+        return 1;
+    }
+    const std::string path = lua_tostring(L, -2);
+    if (cache->Load(L, path) != LUA_OK) {
+        return luaL_error(L, "error loading module '%s' from file '%s':\n\t%s", name,
+                          path.c_str(), lua_tostring(L, -1));
+    }
+    lua_pushstring(L, path.c_str());
+    return 2;
+}
+
+void BytecodeCache::InstallSearcher(lua_State* L) {
+    lua_getglobal(L, "package");
+#if LUA_VERSION_NUM >= 502
+    lua_getfield(L, -1, "searchers");
+#else
+    lua_getfield(L, -1, "loaders");
+#endif
+    // Second searcher is the Lua file searcher, first looks in package.preload
+    lua_pushlightuserdata(L, this);
+    lua_pushcclosure(L, CachedSearcher, 1);
+    lua_rawseti(L, -2, 2);
+    lua_pop(L, 2);
+}
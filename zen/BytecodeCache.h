@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+struct lua_State;
+
+// Compiled Lua chunks cached on disk, so that configuration and required modules are not
+// parsed again on every start. Entries are keyed by path, and valid while modification
+// time, hash of the source and the Lua version that dumped them match. Sources are still
+// read to be hashed, parsing is what is saved.
+//
+// Safe to use from several threads, each with a Lua state of its own. Takes the raw Lua
+// state to keep sol2 out of headers.
+class BytecodeCache {
+   public:
+    // Cache in XDG_CACHE_HOME/zenway or ~/.cache/zenway, disabled if neither is known
+    static BytecodeCache& Shared();
+    explicit BytecodeCache(std::filesystem::path directory) : m_directory(directory) {}
+
+    // Loads file like luaL_loadfile, pushing the chunk or an error message. Compiled from
+    // source and written to the cache on miss.
+    int Load(lua_State* L, const std::string& path);
+    // Replaces the Lua file searcher of require with one loading through the cache
+    void InstallSearcher(lua_State* L);
+
+    int Hits() const { return m_hits; }
+    int Misses() const { return m_misses; }
+
+   private:
+    std::filesystem::path EntryPath(const std::string& path) const;
+
+    std::filesystem::path m_directory;  // Empty when disabled
+    std::atomic<int> m_hits = 0;
+    std::atomic<int> m_misses = 0;
+};
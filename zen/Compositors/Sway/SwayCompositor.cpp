@@ -109,7 +109,8 @@ static bool ParseBarStateUpdateEvent(const std::string &payload) {
 }
 
 static void ParseApplication(Workspace &workspace, nlohmann::basic_json<> applicationNode,
-                             int nextFocusId, std::set<int> &alerts, bool &newAlert) {
+                             int nextFocusId, std::set<int> &alerts,
+                             std::vector<AlertEvent> &alertEvents) {
     if (!IsNodeType(applicationNode, "con") && !IsNodeType(applicationNode, "floating_con")) {
         spdlog::error("Expected app");
         return;
@@ -121,7 +122,7 @@ static void ParseApplication(Workspace &workspace, nlohmann::basic_json<> applic
     if (applicationname.is_null()) {
         auto applicationNodes = applicationNode["nodes"];
         for (auto &innerApplicationNode : applicationNodes) {
-            ParseApplication(workspace, innerApplicationNode, nextFocusId, alerts, newAlert);
+            ParseApplication(workspace, innerApplicationNode, nextFocusId, alerts, alertEvents);
         }
         return;
     }
@@ -141,21 +142,26 @@ static void ParseApplication(Workspace &workspace, nlohmann::basic_json<> applic
     }
     application.isAlerted = GetUrgent(applicationNode);
     workspace.isAlerted = workspace.isAlerted || application.isAlerted;
-    workspace.applications.push_back(std::move(application));
     // Maintain alert state
+    auto alert = Alert{.kind = AlertKind::Window,
+                       .priority = AlertPriority::Normal,
+                       .id = std::to_string(applicationId),
+                       .message = application.name};
     if (alerts.contains(applicationId)) {
         if (!application.isAlerted) {
             alerts.erase(applicationId);
+            alertEvents.push_back(AlertEvent{.isRaised = false, .alert = std::move(alert)});
         }  // else, still alerted, already triggered alert.
     } else if (application.isAlerted) {
         // Should trigger new alert!
         alerts.insert(applicationId);
-        newAlert = true;
+        alertEvents.push_back(AlertEvent{.isRaised = true, .alert = std::move(alert)});
     }
+    workspace.applications.push_back(std::move(application));
 }
 
 static std::optional<Displays> ParseTree(const std::string &payload, AlertStates &alertStates,
-                                         bool &newAlert) {
+                                         std::vector<AlertEvent> &alertEvents) {
     auto rootNode = json::parse(payload, Filter, false /*ignoring exceptions*/);
     if (rootNode.is_discarded()) {
         spdlog::error("Failed to parse Sway tree");
@@ -185,6 +191,12 @@ static std::optional<Displays> ParseTree(const std::string &payload, AlertStates
         auto display = Display(GetName(outputNode));
         // Retrieve alert state for display
         auto &alerts = alertStates[display.name];
+        // First in focus order is the workspace shown on the display
+        int visibleId = -1;
+        for (auto n : outputNode["focus"]) {
+            visibleId = n.get<int>();
+            break;
+        }
         // Iterate over workspaces
         auto workspaceNodes = outputNode["nodes"];
         if (!IsArray(workspaceNodes)) {
@@ -197,6 +209,7 @@ static std::optional<Displays> ParseTree(const std::string &payload, AlertStates
             }
             auto workspace = Workspace(GetName(workspaceNode));
             workspace.isAlerted = GetUrgent(workspaceNode);
+            workspace.isVisible = workspaceNode["id"].get<int>() == visibleId;
             //   Better way?
             auto focusNode = workspaceNode["focus"];
             int nextFocusId = -1;
@@ -210,7 +223,7 @@ static std::optional<Displays> ParseTree(const std::string &payload, AlertStates
                 continue;
             }
             for (auto applicationNode : applicationNodes) {
-                ParseApplication(workspace, applicationNode, nextFocusId, alerts, newAlert);
+                ParseApplication(workspace, applicationNode, nextFocusId, alerts, alertEvents);
             }
             display.isFocused = display.isFocused || workspace.isFocused;
             display.isAlerted = display.isAlerted || workspace.isAlerted;
@@ -222,7 +235,8 @@ static std::optional<Displays> ParseTree(const std::string &payload, AlertStates
 }
 
 std::shared_ptr<SwayCompositor> SwayCompositor::Connect(std::shared_ptr<MainLoop> mainloop,
-                                                        Visibility visibility) {
+                                                        Visibility visibility,
+                                                        DisplaysChanged displaysChanged) {
     auto path = getenv("SWAYSOCK");
     if (path == nullptr) {
         spdlog::error("SWAYSOCK not set");
@@ -242,7 +256,8 @@ std::shared_ptr<SwayCompositor> SwayCompositor::Connect(std::shared_ptr<MainLoop
         close(fd);
         return nullptr;
     }
-    auto t = std::shared_ptr<SwayCompositor>(new SwayCompositor(mainloop, fd, visibility));
+    auto t = std::shared_ptr<SwayCompositor>(
+        new SwayCompositor(mainloop, fd, visibility, displaysChanged));
     mainloop->RegisterIoHandler(fd, "Sway", t);
     t->Initialize();
     return t;
@@ -284,15 +299,22 @@ bool SwayCompositor::OnRead() {
     switch (msg) {
         case Message::GET_TREE: {
             spdlog::trace("Received sway tree");
-            bool newAlert = false;
-            auto maybeDisplays = ParseTree(m_payload, m_alertStates, newAlert);
+            std::vector<AlertEvent> alertEvents;
+            auto maybeDisplays = ParseTree(m_payload, m_alertStates, alertEvents);
             if (maybeDisplays) {
                 m_displays = std::move(*maybeDisplays);
                 m_drawn = m_published = false;
+                if (m_displaysChanged) {
+                    m_displaysChanged(m_displays);
+                }
             }  // else, error!
-            if (newAlert) {
+            for (auto &event : alertEvents) {
                 spdlog::debug("Alert in SwayCompositor");
-                m_mainloop->AlertAndWakeup();
+                if (event.isRaised) {
+                    m_mainloop->AlertAndWakeup(std::move(event.alert));
+                } else {
+                    m_mainloop->ClearAlertAndWakeup(event.alert.kind, event.alert.id);
+                }
             }
             break;
         }
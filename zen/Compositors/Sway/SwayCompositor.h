@@ -6,12 +6,14 @@
 #include "zen/Sources/Sources.h"
 
 using Visibility = std::function<void(bool visibility)>;
+using DisplaysChanged = std::function<void(const Displays& displays)>;
 using AlertStates = std::map<std::string, std::set<int>>;
 
 class SwayCompositor : public IoHandler, public Source {
    public:
     static std::shared_ptr<SwayCompositor> Connect(std::shared_ptr<MainLoop> mainloop,
-                                                   Visibility visibility);
+                                                   Visibility visibility,
+                                                   DisplaysChanged displaysChanged = nullptr);
     virtual ~SwayCompositor();
 
     virtual bool OnRead() override;
@@ -19,12 +21,18 @@ class SwayCompositor : public IoHandler, public Source {
 
    private:
     void Initialize();
-    SwayCompositor(std::shared_ptr<MainLoop> mainloop, int fd, Visibility visibility)
-        : Source(), m_mainloop(mainloop), m_fd(fd), m_visibility(visibility) {}
+    SwayCompositor(std::shared_ptr<MainLoop> mainloop, int fd, Visibility visibility,
+                   DisplaysChanged displaysChanged)
+        : Source(),
+          m_mainloop(mainloop),
+          m_fd(fd),
+          m_visibility(visibility),
+          m_displaysChanged(displaysChanged) {}
     std::shared_ptr<MainLoop> m_mainloop;
     int m_fd;
     std::string m_payload;
     Displays m_displays;
     Visibility m_visibility;
+    DisplaysChanged m_displaysChanged;
     AlertStates m_alertStates;
 };
@@ -0,0 +1,78 @@
+#include "zen/ConfigWatcher.h"
+
+#include <spdlog/spdlog.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+
+// Written in place or replaced by rename, not while being written
+static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO;
+
+std::shared_ptr<ConfigWatcher> ConfigWatcher::Create(std::shared_ptr<MainLoop> mainLoop,
+                                                     OnChanged onChanged) {
+    auto fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1) {
+        spdlog::error("Failed to initialize inotify: {}", strerror(errno));
+        return nullptr;
+    }
+    auto watcher = std::shared_ptr<ConfigWatcher>(new ConfigWatcher(fd, std::move(onChanged)));
+    mainLoop->RegisterIoHandler(fd, "ConfigWatcher", watcher);
+    return watcher;
+}
+
+ConfigWatcher::~ConfigWatcher() { close(m_fd); }
+
+void ConfigWatcher::Watch(const std::vector<std::string>& files) {
+    for (const auto& keyValue : m_directories) {
+        inotify_rm_watch(m_fd, keyValue.first);
+    }
+    m_directories.clear();
+    m_files.clear();
+    std::set<std::string> directories;
+    for (const auto& file : files) {
+        const auto path = std::filesystem::path(file).lexically_normal();
+        m_files.insert(path);
+        directories.insert(path.parent_path());
+    }
+    for (const auto& directory : directories) {
+        const auto wd = inotify_add_watch(m_fd, directory.c_str(), WATCH_MASK);
+        if (wd == -1) {
+            spdlog::error("Failed to watch {}: {}", directory, strerror(errno));
+            continue;
+        }
+        m_directories[wd] = directory;
+        spdlog::debug("Watching {} for configuration changes", directory);
+    }
+}
+
+bool ConfigWatcher::OnRead() {
+    alignas(inotify_event) char buffer[4096];
+    bool isChanged = false;
+    ssize_t n;
+    while ((n = read(m_fd, buffer, sizeof(buffer))) > 0) {
+        for (char* p = buffer; p < buffer + n;) {
+            const auto event = (const inotify_event*)p;
+            p += sizeof(inotify_event) + event->len;
+            auto it = m_directories.find(event->wd);
+            if (it == m_directories.end() || event->len == 0) {
+                continue;
+            }
+            const auto path = std::filesystem::path(it->second) / event->name;
+            if (m_files.contains(path)) {
+                spdlog::debug("Configuration file {} changed", path.c_str());
+                isChanged = true;
+            }
+        }
+    }
+    if (!isChanged) {
+        return false;
+    }
+    auto files = m_onChanged();
+    if (!files.empty()) {
+        Watch(files);
+    }
+    // Nothing to redraw until reloaded
+    return false;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "zen/MainLoop.h"
+
+// Watches the files a configuration was loaded from through inotify and invokes onChanged
+// once per batch of changes. onChanged returns the files to watch from then on, empty to
+// keep watching the same. Directories are watched rather than the files since editors
+// often save by replacing the file.
+class ConfigWatcher : public IoHandler {
+   public:
+    using OnChanged = std::function<std::vector<std::string>()>;
+    static std::shared_ptr<ConfigWatcher> Create(std::shared_ptr<MainLoop> mainLoop,
+                                                 OnChanged onChanged);
+    virtual ~ConfigWatcher();
+
+    // Replaces the watched files
+    void Watch(const std::vector<std::string>& files);
+    bool OnRead() override;
+
+   private:
+    ConfigWatcher(int fd, OnChanged onChanged)
+        : m_fd(fd), m_onChanged(std::move(onChanged)) {}
+
+    int m_fd;
+    OnChanged m_onChanged;
+    std::map<int, std::string> m_directories;  // Directory per watch descriptor
+    std::set<std::string> m_files;
+};
@@ -1,12 +1,17 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
+#include <map>
 #include <memory>
 #include <set>
 #include <vector>
 
 #include "cairo.h"
 #include "pango/pango-layout.h"
+#include "zen/Alert.h"
+#include "zen/LayoutCache.h"
+#include "zen/ThumbnailCache.h"
 
 struct Padding {
     int left;
@@ -60,21 +65,22 @@ struct Renderable {
 };
 
 struct Markup : public Renderable {
-    Markup(const std::string& string) : Renderable(), string(string), m_layout(nullptr) {}
-    virtual ~Markup() {
-        if (m_layout) g_object_unref(m_layout);
-    }
+    Markup(const std::string& string) : Renderable(), bounds({}), string(string) {}
     void Compute(cairo_t* cr) override;
     void Draw(cairo_t* cr, int x, int y, std::vector<Target>& targets) const override;
+    // Markup as rendered, for tests
+    const std::string& String() const { return string; }
+
+    TextBounds bounds;
 
    private:
     const std::string string;
-    PangoLayout* m_layout;
+    std::shared_ptr<const TextLayout> m_layout;
 };
 
 struct MarkupBox : public Renderable {
     MarkupBox(const std::string& string)
-        : Renderable(), markup(string), color({}), border({}), radius(0), padding({}) {}
+        : Renderable(), markup(string), color({}), border({}), radius(0), padding({}), bounds({}) {}
     void Compute(cairo_t* cr) override;
     void Draw(cairo_t* cr, int x, int y, std::vector<Target>& targets) const override;
 
@@ -83,7 +89,26 @@ struct MarkupBox : public Renderable {
     Border border;
     uint8_t radius;
     Padding padding;
+    TextBounds bounds;  // Bounds of the whole box, including padding and border
+    std::string tag;
+};
+
+// Preview of a workspace captured from an output
+struct Thumbnail : public Renderable {
+    Thumbnail(const std::string& output, const std::string& workspace)
+        : Renderable(), output(output), workspace(workspace), width(0), height(0), radius(0) {}
+    void Compute(cairo_t* cr) override;
+    void Draw(cairo_t* cr, int x, int y, std::vector<Target>& targets) const override;
+
+    const std::string output;
+    const std::string workspace;
+    int width;   // Max width, 0 to use captured size
+    int height;  // Max height, 0 to keep aspect from width
+    int radius;
     std::string tag;
+
+   private:
+    std::shared_ptr<const ThumbnailImage> m_image;
 };
 
 struct FlexContainer : public Renderable {
@@ -104,11 +129,16 @@ struct WidgetConfig {
     std::function<void(std::string_view tag, int value)> wheel;
     std::set<std::string> sources;
     Padding padding;
+    // True while drawn empty after the render function overran its budget, the widget is
+    // rendered on every draw until it renders again. Null for templates.
+    std::function<bool()> isBackedOff;
 };
 
 struct Widget {
     Widget() : computed({}), m_renderable(nullptr), m_paddingX(0), m_paddingY(0) {}
     void Compute(const WidgetConfig& config, const std::string& outputName, cairo_t* cr);
+    // Computes a renderable already returned by the render function
+    void Compute(const WidgetConfig& config, std::unique_ptr<Renderable> item, cairo_t* cr);
     void Draw(cairo_t* cr, int x, int y, std::vector<Target>& targets) const;
     Size computed;
 
@@ -124,6 +154,7 @@ struct PanelConfig {
     Anchor anchor;
     bool isColumn;
     std::function<bool(const std::string& outputName)> checkDisplay;
+    std::chrono::microseconds budget;  // Time to draw a frame in, zero for unlimited
 };
 
 enum class Compositor {
@@ -142,13 +173,30 @@ struct AudioConfig {
     SoundServer soundServer;
 };
 
+struct AlertsConfig {
+    // Milliseconds until an alert of a kind expires, 0 to never expire
+    std::map<AlertKind, int> timeouts;
+
+    int TimeoutFor(AlertKind kind) const {
+        auto it = timeouts.find(kind);
+        return it != timeouts.end() ? it->second : 0;
+    }
+};
+
 class Configuration {
    public:
     std::vector<PanelConfig> panels;
     PanelConfig alertPanel;
+    AlertsConfig alerts;
     DisplaysConfig displays;
     AudioConfig audio;
     int bufferWidth;
     int bufferHeight;
     int numBuffers;
+    // Lua states render functions are called in parallel in, 1 to call all on main thread
+    int renderWorkers;
+    // Sources defined by a poll function in configuration and how often it is called
+    std::map<std::string, std::chrono::milliseconds> luaSources;
+    // Configuration file and modules it required, reloaded when any changes
+    std::vector<std::string> files;
 };
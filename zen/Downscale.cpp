@@ -0,0 +1,82 @@
+#include "zen/Downscale.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Average of the block sums, rounded to nearest
+static inline uint8_t Average(uint32_t sum, uint32_t count) {
+    return (uint8_t)((sum + count / 2) / count);
+}
+
+void BoxDownscaleScalar(const uint8_t* src, int cx, int cy, ptrdiff_t srcStride, int factor,
+                        uint8_t* dst, ptrdiff_t dstStride) {
+    const int dstCx = cx / factor;
+    const int dstCy = cy / factor;
+    const uint32_t count = factor * factor;
+    for (int dy = 0; dy < dstCy; dy++) {
+        uint8_t* out = dst + dy * dstStride;
+        for (int dx = 0; dx < dstCx; dx++) {
+            uint32_t sum[4] = {0, 0, 0, 0};
+            for (int y = 0; y < factor; y++) {
+                const uint8_t* in = src + (dy * factor + y) * srcStride + dx * factor * 4;
+                for (int x = 0; x < factor * 4; x += 4) {
+                    sum[0] += in[x];
+                    sum[1] += in[x + 1];
+                    sum[2] += in[x + 2];
+                    sum[3] += in[x + 3];
+                }
+            }
+            for (int c = 0; c < 4; c++) {
+                out[dx * 4 + c] = Average(sum[c], count);
+            }
+        }
+    }
+}
+
+#if defined(__SSE2__)
+void BoxDownscale(const uint8_t* src, int cx, int cy, ptrdiff_t srcStride, int factor,
+                  uint8_t* dst, ptrdiff_t dstStride) {
+    const int dstCx = cx / factor;
+    const int dstCy = cy / factor;
+    const uint32_t count = factor * factor;
+    const __m128i zero = _mm_setzero_si128();
+    for (int dy = 0; dy < dstCy; dy++) {
+        uint8_t* out = dst + dy * dstStride;
+        for (int dx = 0; dx < dstCx; dx++) {
+            // Four 32 bit lanes, one per channel
+            __m128i acc = zero;
+            uint32_t sum[4] = {0, 0, 0, 0};
+            for (int y = 0; y < factor; y++) {
+                const uint8_t* in = src + (dy * factor + y) * srcStride + dx * factor * 4;
+                int x = 0;
+                // Four pixels at a time, widened to 16 bits and pairwise added before
+                // widening to 32 bits. A pair of bytes can not overflow 16 bits.
+                for (; x + 4 <= factor; x += 4) {
+                    const __m128i pixels = _mm_loadu_si128((const __m128i*)(in + x * 4));
+                    const __m128i pairs = _mm_add_epi16(_mm_unpacklo_epi8(pixels, zero),
+                                                        _mm_unpackhi_epi8(pixels, zero));
+                    acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(pairs, zero));
+                    acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(pairs, zero));
+                }
+                for (; x < factor; x++) {
+                    sum[0] += in[x * 4];
+                    sum[1] += in[x * 4 + 1];
+                    sum[2] += in[x * 4 + 2];
+                    sum[3] += in[x * 4 + 3];
+                }
+            }
+            alignas(16) uint32_t lanes[4];
+            _mm_store_si128((__m128i*)lanes, acc);
+            for (int c = 0; c < 4; c++) {
+                out[dx * 4 + c] = Average(sum[c] + lanes[c], count);
+            }
+        }
+    }
+}
+#else
+void BoxDownscale(const uint8_t* src, int cx, int cy, ptrdiff_t srcStride, int factor,
+                  uint8_t* dst, ptrdiff_t dstStride) {
+    BoxDownscaleScalar(src, cx, cy, srcStride, factor, dst, dstStride);
+}
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Box filter downscaling of 32 bit pixels (ARGB32/XRGB8888 or any other four byte
+// format) by an integer factor. Each destination pixel is the average of a factor x
+// factor block of source pixels, per channel. The destination is (cx / factor) x
+// (cy / factor), remaining source pixels are ignored. Strides are in bytes and might be
+// negative for bottom up images.
+void BoxDownscale(const uint8_t* src, int cx, int cy, ptrdiff_t srcStride, int factor,
+                  uint8_t* dst, ptrdiff_t dstStride);
+
+// Plain C++ implementation, used when SSE2 is not available and for verification
+void BoxDownscaleScalar(const uint8_t* src, int cx, int cy, ptrdiff_t srcStride, int factor,
+                        uint8_t* dst, ptrdiff_t dstStride);
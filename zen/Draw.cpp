@@ -3,6 +3,17 @@
 #include "pango/pango-layout.h"
 #include "pango/pangocairo.h"
 #include "spdlog/spdlog.h"
+#include "zen/Metrics.h"
+
+// Consecutive frames over budget before stepping down
+static constexpr int OVERRUNS_TO_DEGRADE = 3;
+// Consecutive frames within half the budget before stepping up
+static constexpr int HEADROOM_TO_RESTORE = 30;
+// Widgets are rendered at least this often even when reusing stale widgets
+static constexpr int MAX_STALE_FRAMES = 4;
+
+// Quality of the panel currently being drawn
+static Quality s_quality = Quality::Full;
 
 static void LogComputed(const Size& computed, const char* s) {
     spdlog::trace("Computed {}: {}x{}", s, computed.cx, computed.cy);
@@ -10,26 +21,29 @@ static void LogComputed(const Size& computed, const char* s) {
 
 static void LogDraw(const char* s, int x, int y) { spdlog::trace("Draw {}: {},{}", s, x, y); }
 
-void Markup::Compute(cairo_t* cr) {
-    // pango_layout_set_width(m_layout, m_config.cx * PANGO_SCALE);
-    // pango_layout_set_height(m_layout, m_config.cy * PANGO_SCALE);
-    m_layout = pango_cairo_create_layout(cr);
-    pango_layout_set_markup(m_layout, string.c_str(), -1);
-    PangoRectangle rect;
-    pango_layout_get_extents(m_layout, nullptr, &rect);
-    pango_extents_to_pixels(&rect, nullptr);
-    computed.cx = rect.width;
-    computed.cy = rect.height;
-    LogComputed(computed, ("Markup " + string).c_str());
+void Markup::Compute(cairo_t*) {
+    m_layout = LayoutCache::Shared().Lookup(string, bounds);
+    computed.cx = m_layout->cx;
+    computed.cy = m_layout->cy;
+    LogComputed(computed, "Markup");
 }
 
 void Markup::Draw(cairo_t* cr, int x, int y, std::vector<Target>&) const {
     LogDraw("Markup", x, y);
+    if (m_layout->clip) {
+        cairo_save(cr);
+        cairo_rectangle(cr, x, y, computed.cx, computed.cy);
+        cairo_clip(cr);
+    }
     cairo_move_to(cr, x, y);
-    pango_cairo_show_layout(cr, m_layout);
+    pango_cairo_show_layout(cr, m_layout->layout);
+    if (m_layout->clip) {
+        cairo_restore(cr);
+    }
 }
 
-static void BeginRectangleSubPath(cairo_t* cr, int x, int y, int cx, int cy, int radius) {
+static void BeginRectangleSubPath(cairo_t* cr, double x, double y, double cx, double cy,
+                                  double radius) {
     constexpr double degrees = M_PI / 180.0;
     cairo_new_sub_path(cr);
     // A-----B
@@ -46,7 +60,18 @@ static void BeginRectangleSubPath(cairo_t* cr, int x, int y, int cx, int cy, int
     cairo_close_path(cr);
 }
 
+// Bounds of the markup within a box
+static int InnerBound(int bound, int padding, int border) {
+    if (bound <= 0) return 0;
+    // Leave at least a pixel to avoid unbounding
+    return std::max(bound - padding - (2 * border), 1);
+}
+
 void MarkupBox::Compute(cairo_t* cr) {
+    markup.bounds = TextBounds{
+        .maxWidth = InnerBound(bounds.maxWidth, padding.left + padding.right, border.width),
+        .maxHeight = InnerBound(bounds.maxHeight, padding.top + padding.bottom, border.width),
+        .ellipsize = bounds.ellipsize};
     markup.Compute(cr);
     computed = markup.computed;
     computed.cx += padding.left + padding.right + (2 * border.width);
@@ -59,7 +84,21 @@ void MarkupBox::Draw(cairo_t* cr, int x, int y, std::vector<Target>& targets) co
     BeginRectangleSubPath(cr, x + border.width, y + border.width, computed.cx - (2 * border.width),
                           computed.cy - (2 * border.width), radius);
     // Border
-    if (border.width) {
+    if (border.width && s_quality >= Quality::PlainBorders) {
+        // Stroke centered on an outset path, close enough without the cost of a mask
+        cairo_save(cr);
+        cairo_new_path(cr);
+        const double half = border.width / 2.0;
+        BeginRectangleSubPath(cr, x + half, y + half, computed.cx - border.width,
+                              computed.cy - border.width, radius + half);
+        cairo_set_line_width(cr, border.width);
+        cairo_set_source_rgba(cr, border.color.r, border.color.g, border.color.b, border.color.a);
+        cairo_stroke(cr);
+        cairo_restore(cr);
+        BeginRectangleSubPath(cr, x + border.width, y + border.width,
+                              computed.cx - (2 * border.width), computed.cy - (2 * border.width),
+                              radius);
+    } else if (border.width) {
         // Cairo draws lines with half of the line width within the edge and the
         // other half outside. We want everything on the outside.
         cairo_push_group_with_content(cr, CAIRO_CONTENT_ALPHA);
@@ -128,7 +167,10 @@ void FlexContainer::Draw(cairo_t* cr, int x, int y, std::vector<Target>& targets
 }
 
 void Widget::Compute(const WidgetConfig& config, const std::string& outputName, cairo_t* cr) {
-    auto item = config.render(outputName);
+    Compute(config, config.render(outputName), cr);
+}
+
+void Widget::Compute(const WidgetConfig& config, std::unique_ptr<Renderable> item, cairo_t* cr) {
     if (!item) {
         spdlog::error("Bad render return from widget");
         m_paddingX = 0;
@@ -155,10 +197,100 @@ void Widget::Draw(cairo_t* cr, int x, int y, std::vector<Target>& targets) const
     cairo_restore(cr);
 }
 
+void Thumbnail::Compute(cairo_t*) {
+    m_image = ThumbnailCache::Shared().Lookup(output, workspace);
+    if (!m_image) {
+        // Not captured yet, reserve space to avoid layout jumping once it is
+        computed.cx = width;
+        computed.cy = height > 0 ? height : width * 9 / 16;
+        LogComputed(computed, "Thumbnail");
+        return;
+    }
+    // Fit within bounds, keeping aspect
+    double scale = 1.0;
+    if (width > 0) {
+        scale = std::min(scale, (double)width / m_image->cx);
+    }
+    if (height > 0) {
+        scale = std::min(scale, (double)height / m_image->cy);
+    }
+    computed.cx = m_image->cx * scale;
+    computed.cy = m_image->cy * scale;
+    LogComputed(computed, "Thumbnail");
+}
+
+void Thumbnail::Draw(cairo_t* cr, int x, int y, std::vector<Target>& targets) const {
+    LogDraw("Thumbnail", x, y);
+    if (!tag.empty()) {
+        targets.push_back(Target{.position = {x, y, computed.cx, computed.cy}, .tag = tag});
+    }
+    if (!m_image || computed.cx <= 0 || computed.cy <= 0) {
+        return;
+    }
+    cairo_save(cr);
+    if (radius > 0) {
+        BeginRectangleSubPath(cr, x, y, computed.cx, computed.cy, radius);
+        cairo_clip(cr);
+    }
+    cairo_translate(cr, x, y);
+    cairo_scale(cr, (double)computed.cx / m_image->cx, (double)computed.cy / m_image->cy);
+    cairo_set_source_surface(cr, m_image->surface, 0, 0);
+    cairo_paint(cr);
+    cairo_restore(cr);
+}
+
 enum class Align { Left, Right, Top, Bottom, CenterX, CenterY };
 
+static const char* QualityName(Quality quality) {
+    switch (quality) {
+        case Quality::Full:
+            return "full";
+        case Quality::PlainBorders:
+            return "plain borders";
+        case Quality::NoAntialias:
+            return "no antialias";
+        case Quality::StaleWidgets:
+            return "stale widgets";
+    }
+    return "";
+}
+
+bool FrameBudget::Record(std::chrono::microseconds elapsed, std::chrono::microseconds budget) {
+    if (budget.count() <= 0) {
+        return false;
+    }
+    if (elapsed > budget) {
+        Metrics::Shared().Add("draw.over_budget");
+        headroom = 0;
+        if (++overruns < OVERRUNS_TO_DEGRADE || quality == Quality::StaleWidgets) {
+            return false;
+        }
+        overruns = 0;
+        quality = Quality((int)quality + 1);
+        Metrics::Shared().Add("draw.degraded");
+        return true;
+    }
+    overruns = 0;
+    if (elapsed * 2 > budget || quality == Quality::Full) {
+        headroom = 0;
+        return false;
+    }
+    if (++headroom < HEADROOM_TO_RESTORE) {
+        return false;
+    }
+    headroom = 0;
+    quality = Quality((int)quality - 1);
+    Metrics::Shared().Add("draw.restored");
+    return true;
+}
+
 bool Draw::Panel(const PanelConfig& panelConfig, const std::string& outputName,
-                 BufferPool& bufferPool, DrawnPanel& drawn) {
+                 BufferPool& bufferPool, DrawnPanel& drawn,
+                 const std::vector<bool>& dirtyWidgets) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    // Only valid for this draw
+    auto prerendered = std::move(drawn.prerendered);
     // Get free buffer to draw in. This could fail if both buffers are locked.
     auto buffer = bufferPool.Get();
     if (!buffer) {
@@ -169,14 +301,33 @@ bool Draw::Panel(const PanelConfig& panelConfig, const std::string& outputName,
     // TODO: Could delay this to only clear part that will be used when drawing
     auto cr = buffer->GetCairoCtx();
     buffer->Clear(0x00);
+    s_quality = drawn.budget.quality;
+    cairo_set_antialias(cr, s_quality >= Quality::NoAntialias ? CAIRO_ANTIALIAS_NONE
+                                                              : CAIRO_ANTIALIAS_DEFAULT);
+    // Widgets rendered in previous frame are reused unless dirty
+    const bool hasRendered = drawn.rendered.size() == panelConfig.widgets.size();
+    // Reuse even dirty widgets when way over budget, but not forever
+    const bool stale = s_quality == Quality::StaleWidgets &&
+                       drawn.staleFrames < MAX_STALE_FRAMES && hasRendered;
+    auto widgets = hasRendered ? std::move(drawn.rendered)
+                               : std::vector<Widget>(panelConfig.widgets.size());
+    drawn.staleFrames = stale ? drawn.staleFrames + 1 : 0;
     // Calculate size of all widgets and track max width and height
-    auto widgets = std::vector<Widget>(panelConfig.widgets.size());
     int maxCx = 0, maxCy = 0;
     int cx = 0, cy = 0;
+    int numRendered = 0;
     for (size_t i = 0; i < widgets.size(); i++) {
         auto& widget = widgets[i];
         auto& config = panelConfig.widgets[i];
-        widget.Compute(config, outputName, cr);
+        const bool isDirty = !hasRendered || dirtyWidgets.empty() || dirtyWidgets.at(i);
+        if (isDirty && !stale) {
+            if (i < prerendered.size() && prerendered[i]) {
+                widget.Compute(config, std::move(prerendered[i]), cr);
+            } else {
+                widget.Compute(config, outputName, cr);
+            }
+            numRendered++;
+        }
         maxCx = std::max(maxCx, widget.computed.cx);
         maxCy = std::max(maxCy, widget.computed.cy);
         cx += widget.computed.cx;
@@ -256,5 +407,20 @@ bool Draw::Panel(const PanelConfig& panelConfig, const std::string& outputName,
     }
     drawn.size = Size{cx, cy};
     drawn.buffer = buffer;
+    drawn.rendered = std::move(widgets);
+    // Measure against budget and adapt quality of coming frames
+    const auto elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+    const auto metric = fmt::format("draw.panel{}", panelConfig.index);
+    Metrics::Shared().Set(metric + ".us", elapsed.count());
+    Metrics::Shared().Add("draw.widgets_rendered", numRendered);
+    Metrics::Shared().Add("draw.widgets_reused",
+                          (int64_t)panelConfig.widgets.size() - numRendered);
+    if (drawn.budget.Record(elapsed, panelConfig.budget)) {
+        spdlog::info("Panel {} drew in {}us with budget {}us, quality now {}", panelConfig.index,
+                     elapsed.count(), panelConfig.budget.count(),
+                     QualityName(drawn.budget.quality));
+        Metrics::Shared().Set(metric + ".quality", (int64_t)drawn.budget.quality);
+    }
     return true;
 }
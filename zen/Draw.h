@@ -13,14 +13,42 @@ struct DrawnWidget {
     std::vector<Target> targets;
 };
 
+// Quality steps taken when a panel does not draw within its budget, in order
+enum class Quality {
+    Full,
+    PlainBorders,  // Borders stroked directly instead of through a mask
+    NoAntialias,   // Shapes drawn without antialiasing, text is unaffected
+    StaleWidgets,  // Widgets from previous frame reused without rendering them again
+};
+
+// Tracks draw times of a panel against its budget and steps quality down when over
+// budget and back up when there is headroom again.
+struct FrameBudget {
+    FrameBudget() : quality(Quality::Full), overruns(0), headroom(0) {}
+    // Returns true if quality changed
+    bool Record(std::chrono::microseconds elapsed, std::chrono::microseconds budget);
+
+    Quality quality;
+    int overruns;  // Consecutive frames over budget
+    int headroom;  // Consecutive frames well within budget
+};
+
 struct DrawnPanel {
-    DrawnPanel() : buffer(nullptr), size{} {}
+    DrawnPanel() : buffer(nullptr), size{}, staleFrames(0) {}
     std::shared_ptr<Buffer> buffer;
     Size size;
     std::vector<DrawnWidget> widgets;
+    // Rendered widgets of last frame, reused when not dirty or quality is StaleWidgets
+    std::vector<Widget> rendered;
+    // Widgets rendered by render workers ahead of next draw, null where not rendered
+    std::vector<std::unique_ptr<Renderable>> prerendered;
+    int staleFrames;
+    FrameBudget budget;
 };
 
 struct Draw {
+    // Only widgets flagged in dirtyWidgets are rendered again, empty means all are dirty.
     static bool Panel(const PanelConfig& panelConfig, const std::string& outputName,
-                      BufferPool& bufferPool, DrawnPanel& drawn);
+                      BufferPool& bufferPool, DrawnPanel& drawn,
+                      const std::vector<bool>& dirtyWidgets);
 };
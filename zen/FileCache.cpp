@@ -0,0 +1,154 @@
+#include "zen/FileCache.h"
+
+#include <spdlog/spdlog.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "zen/Metrics.h"
+
+// Written in place, replaced, created or removed
+static const uint32_t WATCH_MASK =
+    IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+
+CachedFile::CachedFile(std::string content_) : content(std::move(content_)) {
+    // Like io.lines, no empty line after a trailing newline
+    std::string_view rest = content;
+    while (!rest.empty()) {
+        const auto end = rest.find('\n');
+        lines.push_back(rest.substr(0, end));
+        rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+    }
+}
+
+FileCache& FileCache::Shared() {
+    static FileCache cache;
+    return cache;
+}
+
+FileCache::FileCache() {
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd == -1) {
+        spdlog::error("Failed to initialize inotify for files: {}", strerror(errno));
+    }
+}
+
+FileCache::~FileCache() {
+    if (m_fd != -1) {
+        close(m_fd);
+    }
+}
+
+class FileCache::Handler : public IoHandler {
+   public:
+    bool OnRead() override {
+        auto& cache = FileCache::Shared();
+        if (!cache.Invalidate()) {
+            return false;
+        }
+        if (cache.m_onChanged) {
+            cache.m_onChanged();
+        }
+        return true;
+    }
+};
+
+void FileCache::Attach(std::shared_ptr<MainLoop> mainLoop) {
+    if (m_fd != -1) {
+        mainLoop->RegisterIoHandler(m_fd, "FileCache", std::make_shared<Handler>());
+    }
+}
+
+static bool IsNotifying(const std::filesystem::path& path) {
+    const auto root = path.begin() != path.end() ? std::next(path.begin()) : path.end();
+    return root == path.end() || (*root != "proc" && *root != "sys");
+}
+
+static std::shared_ptr<const CachedFile> ReadFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return nullptr;
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    return std::make_shared<const CachedFile>(std::move(content).str());
+}
+
+bool FileCache::Watch(const std::string& directory) {
+    if (m_watched.contains(directory)) {
+        return true;
+    }
+    const auto wd = inotify_add_watch(m_fd, directory.c_str(), WATCH_MASK);
+    if (wd == -1) {
+        spdlog::warn("Failed to watch {}, files in it are not cached: {}", directory,
+                     strerror(errno));
+        return false;
+    }
+    m_directories[wd] = directory;
+    m_watched.insert(directory);
+    spdlog::debug("Watching {} for file changes", directory);
+    return true;
+}
+
+std::shared_ptr<const CachedFile> FileCache::Read(const std::string& path) {
+    const auto absolute = std::filesystem::absolute(path).lexically_normal();
+    if (m_fd == -1 || !IsNotifying(absolute)) {
+        Metrics::Shared().Add("fs.misses");
+        return ReadFile(absolute);
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_files.find(absolute);
+    if (it != m_files.end()) {
+        Metrics::Shared().Add("fs.hits");
+        return it->second;
+    }
+    Metrics::Shared().Add("fs.misses");
+    // Watched before reading to not miss a change in between
+    const bool isWatched = Watch(absolute.parent_path());
+    auto file = ReadFile(absolute);
+    if (isWatched) {
+        m_files.emplace(absolute, file);
+    }
+    return file;
+}
+
+bool FileCache::Invalidate() {
+    alignas(inotify_event) char buffer[4096];
+    bool isChanged = false;
+    ssize_t n;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while ((n = read(m_fd, buffer, sizeof(buffer))) > 0) {
+        for (char* p = buffer; p < buffer + n;) {
+            const auto event = (const inotify_event*)p;
+            p += sizeof(inotify_event) + event->len;
+            auto it = m_directories.find(event->wd);
+            if (it == m_directories.end()) {
+                continue;
+            }
+            const auto& directory = it->second;
+            if (event->mask & IN_IGNORED) {
+                // Directory removed, files in it are watched again when read
+                std::erase_if(m_files, [&directory](const auto& keyValue) {
+                    return std::filesystem::path(keyValue.first).parent_path() == directory;
+                });
+                m_watched.erase(directory);
+                m_directories.erase(it);
+                isChanged = true;
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+            const auto path = std::filesystem::path(directory) / event->name;
+            if (m_files.erase(path) > 0) {
+                spdlog::debug("File {} changed", path.c_str());
+                isChanged = true;
+            }
+        }
+    }
+    return isChanged;
+}
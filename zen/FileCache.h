@@ -0,0 +1,59 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "zen/MainLoop.h"
+
+// Content of a file as last read. Lines point into content.
+struct CachedFile {
+    CachedFile(std::string content_);
+    CachedFile(const CachedFile&) = delete;
+    CachedFile& operator=(const CachedFile&) = delete;
+
+    const std::string content;
+    std::vector<std::string_view> lines;
+};
+
+// Caches files read by configurations, for zen.fs. Directories of cached files are watched
+// through inotify and changed files are dropped when the events are read. Files in /proc
+// and /sys never notify changes, those are read every time. Render workers read
+// concurrently.
+class FileCache {
+   public:
+    static FileCache& Shared();
+    ~FileCache();
+
+    // Null if the file could not be read
+    std::shared_ptr<const CachedFile> Read(const std::string& path);
+    // Inotify fd, readable when there are events to invalidate. Negative if inotify failed
+    // and nothing is cached.
+    int Fd() const { return m_fd; }
+    // Drops changed files, returns true if any of them were cached
+    bool Invalidate();
+    // Invalidates on the main loop from now on, whether or not anything renders on changes.
+    // Files are read on render workers and poll threads, the main loop is only touched here.
+    void Attach(std::shared_ptr<MainLoop> mainLoop);
+    // Invoked on the main loop when cached files have changed
+    void SetOnChanged(std::function<void()> onChanged) { m_onChanged = std::move(onChanged); }
+
+   private:
+    class Handler;
+
+    FileCache();
+    bool Watch(const std::string& directory);
+
+    std::mutex m_mutex;
+    int m_fd;
+    // Missing files are cached as null, until created
+    std::map<std::string, std::shared_ptr<const CachedFile>> m_files;
+    std::map<int, std::string> m_directories;  // Directory per watch descriptor
+    std::set<std::string> m_watched;
+    std::function<void()> m_onChanged;  // Main loop only
+};
@@ -0,0 +1,42 @@
+#include "zen/HeadlessSurface.h"
+
+#include <spdlog/spdlog.h>
+
+std::unique_ptr<HeadlessSurface> HeadlessSurface::Create(PanelConfig panelConfig) {
+    return std::unique_ptr<HeadlessSurface>(new HeadlessSurface(std::move(panelConfig)));
+}
+
+void HeadlessSurface::Draw(BufferPool &bufferPool, const std::string &outputName,
+                           const std::vector<bool> &dirtyWidgets) {
+    m_drawn.widgets.clear();
+    m_drawn.buffer = nullptr;
+    m_drawn.size = Size{};
+    if (!Draw::Panel(m_panelConfig, outputName, bufferPool, m_drawn, dirtyWidgets)) {
+        return;
+    }
+    // Nothing holds on to the buffer, it is free to use for the next draw as soon as the
+    // pixels has been consumed.
+    cairo_surface_flush(m_drawn.buffer->GetCairoSurface());
+}
+
+void HeadlessSurface::Hide() {
+    m_drawn.widgets.clear();
+    m_drawn.buffer = nullptr;
+}
+
+bool HeadlessSurface::WritePng(const std::filesystem::path &path) const {
+    if (!m_drawn.buffer || m_drawn.size.cx <= 0 || m_drawn.size.cy <= 0) {
+        spdlog::error("Nothing drawn to write to {}", path.string());
+        return false;
+    }
+    // Only the part of the buffer used by the panel
+    auto surface = cairo_surface_create_for_rectangle(m_drawn.buffer->GetCairoSurface(), 0, 0,
+                                                      m_drawn.size.cx, m_drawn.size.cy);
+    auto status = cairo_surface_write_to_png(surface, path.c_str());
+    cairo_surface_destroy(surface);
+    if (status != CAIRO_STATUS_SUCCESS) {
+        spdlog::error("Failed to write {}: {}", path.string(), cairo_status_to_string(status));
+        return false;
+    }
+    return true;
+}
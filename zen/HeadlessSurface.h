@@ -0,0 +1,24 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+#include "zen/Surface.h"
+
+// Surface that renders into memory without any compositor. Used to render panels
+// in tests and benchmarks.
+class HeadlessSurface : public Surface {
+   public:
+    static std::unique_ptr<HeadlessSurface> Create(PanelConfig panelConfig);
+    void Draw(BufferPool &bufferPool, const std::string &outputName,
+              const std::vector<bool> &dirtyWidgets) override;
+    void Hide() override;
+
+    // True if last draw produced anything
+    bool IsDrawn() const { return m_drawn.buffer != nullptr; }
+    // Writes the drawn part of the buffer as PNG
+    bool WritePng(const std::filesystem::path &path) const;
+
+   private:
+    HeadlessSurface(PanelConfig panelConfig) : Surface(std::move(panelConfig)) {}
+};
@@ -0,0 +1,99 @@
+#include "zen/LayoutCache.h"
+
+#include "pango/pangocairo.h"
+#include "spdlog/spdlog.h"
+#include "zen/Metrics.h"
+
+// Number of generations an unused layout is kept around
+static constexpr uint64_t KEEP_GENERATIONS = 4;
+
+LayoutCache& LayoutCache::Shared() {
+    static LayoutCache cache;
+    return cache;
+}
+
+LayoutCache::LayoutCache() : m_generation(0) {
+    // Layouts are created from a scratch context with the same format as the
+    // buffers drawn to, this makes them independent of any specific buffer.
+    m_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+    m_cr = cairo_create(m_surface);
+    m_context = pango_cairo_create_context(m_cr);
+}
+
+LayoutCache::~LayoutCache() {
+    m_entries.clear();
+    g_object_unref(m_context);
+    cairo_destroy(m_cr);
+    cairo_surface_destroy(m_surface);
+}
+
+static PangoEllipsizeMode ToPango(Ellipsize ellipsize) {
+    switch (ellipsize) {
+        case Ellipsize::Start:
+            return PANGO_ELLIPSIZE_START;
+        case Ellipsize::Middle:
+            return PANGO_ELLIPSIZE_MIDDLE;
+        case Ellipsize::End:
+            return PANGO_ELLIPSIZE_END;
+        case Ellipsize::None:
+            break;
+    }
+    return PANGO_ELLIPSIZE_NONE;
+}
+
+std::shared_ptr<const TextLayout> LayoutCache::Create(const std::string& markup,
+                                                      const TextBounds& bounds) {
+    auto text = std::make_shared<TextLayout>(pango_layout_new(m_context));
+    auto layout = text->layout;
+    pango_layout_set_markup(layout, markup.c_str(), -1);
+    if (bounds.maxWidth > 0) {
+        // Without ellipsizing the text is wrapped instead
+        pango_layout_set_width(layout, bounds.maxWidth * PANGO_SCALE);
+        pango_layout_set_wrap(layout, PANGO_WRAP_WORD_CHAR);
+        pango_layout_set_ellipsize(layout, ToPango(bounds.ellipsize));
+    }
+    if (bounds.maxHeight > 0 && bounds.ellipsize != Ellipsize::None) {
+        pango_layout_set_height(layout, bounds.maxHeight * PANGO_SCALE);
+    }
+    PangoRectangle rect;
+    pango_layout_get_extents(layout, nullptr, &rect);
+    pango_extents_to_pixels(&rect, nullptr);
+    text->cx = rect.width;
+    text->cy = rect.height;
+    text->baseline = pango_layout_get_baseline(layout) / PANGO_SCALE;
+    if (bounds.maxWidth > 0 && text->cx > bounds.maxWidth) {
+        text->cx = bounds.maxWidth;
+    }
+    if (bounds.maxHeight > 0 && text->cy > bounds.maxHeight) {
+        text->cy = bounds.maxHeight;
+        text->clip = true;
+    }
+    return text;
+}
+
+std::shared_ptr<const TextLayout> LayoutCache::Lookup(const std::string& markup,
+                                                      const TextBounds& bounds) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto key = Key(markup, bounds);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        it->second.generation = m_generation;
+        Metrics::Shared().Add("layout.hits");
+        return it->second.layout;
+    }
+    Metrics::Shared().Add("layout.misses");
+    auto layout = Create(markup, bounds);
+    m_entries.emplace(std::move(key), Entry{.layout = layout, .generation = m_generation});
+    return layout;
+}
+
+void LayoutCache::EndGeneration() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t before = m_entries.size();
+    std::erase_if(m_entries, [this](const auto& keyValue) {
+        return m_generation - keyValue.second.generation >= KEEP_GENERATIONS;
+    });
+    m_generation++;
+    spdlog::trace("Layout cache evicted {} layouts, {} left", before - m_entries.size(),
+                  m_entries.size());
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "cairo.h"
+#include "pango/pango-layout.h"
+
+enum class Ellipsize { None, Start, Middle, End };
+
+// Bounds of a text layout in pixels, 0 means unbounded.
+struct TextBounds {
+    int maxWidth;
+    int maxHeight;
+    Ellipsize ellipsize;
+
+    auto operator<=>(const TextBounds& other) const = default;
+};
+
+// Shaped text. Shared by all markups with same string and bounds.
+struct TextLayout {
+    TextLayout(PangoLayout* layout_) : layout(layout_), cx(0), cy(0), baseline(0), clip(false) {}
+    ~TextLayout() { g_object_unref(layout); }
+    TextLayout(const TextLayout&) = delete;
+    TextLayout& operator=(const TextLayout&) = delete;
+
+    PangoLayout* layout;
+    int cx;
+    int cy;
+    int baseline;
+    bool clip;  // Height bounded without ellipsizing, needs clipping when drawn
+};
+
+// Caches shaped text layouts so that unchanged strings are not shaped (and
+// truncated) again on every redraw. Render workers look up measured text concurrently.
+class LayoutCache {
+   public:
+    static LayoutCache& Shared();
+    ~LayoutCache();
+    std::shared_ptr<const TextLayout> Lookup(const std::string& markup, const TextBounds& bounds);
+    // Evicts layouts that has not been used in the last couple of generations. Should be
+    // invoked once per batch of redraws.
+    void EndGeneration();
+
+   private:
+    using Key = std::pair<std::string, TextBounds>;
+    struct Entry {
+        std::shared_ptr<const TextLayout> layout;
+        uint64_t generation;
+    };
+
+    LayoutCache();
+    std::shared_ptr<const TextLayout> Create(const std::string& markup, const TextBounds& bounds);
+
+    std::mutex m_mutex;
+    cairo_surface_t* m_surface;
+    cairo_t* m_cr;
+    PangoContext* m_context;
+    std::map<Key, Entry> m_entries;
+    uint64_t m_generation;
+};
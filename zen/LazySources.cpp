@@ -0,0 +1,259 @@
+#include "zen/LazySources.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "sol/sol.hpp"
+
+// Views are either bound to a slot, following the published state, or to an element
+// of a snapshot that is kept alive by the view.
+template <typename T>
+struct RootView {
+    LazySources::Slot<T> slot;
+};
+
+template <typename T>
+struct ElementView {
+    std::shared_ptr<const void> owner;
+    const T* element;
+};
+
+template <typename T>
+struct ArrayView {
+    std::shared_ptr<const void> owner;
+    const std::vector<T>* elements;
+};
+
+struct NetworkView {
+    std::shared_ptr<const void> owner;
+    const std::pair<const std::string, NetworkState>* network;
+};
+
+using NextResult = std::tuple<sol::object, sol::object>;
+using PairsResult = std::tuple<sol::object, sol::object, sol::object>;
+
+// Iterator functions returned by pairs are created once and kept in the registry
+static const char* NEXT_TABLE = "zen.next";
+template <typename T>
+constexpr const char* NEXT_KEY = nullptr;
+template <>
+constexpr const char* NEXT_KEY<Application> = "applications";
+template <>
+constexpr const char* NEXT_KEY<Workspace> = "workspaces";
+template <>
+constexpr const char* NEXT_KEY<Displays> = "displays";
+template <>
+constexpr const char* NEXT_KEY<Networks> = "networks";
+
+template <typename T, typename View>
+static PairsResult Pairs(sol::this_state L, const View& view) {
+    sol::state_view lua(L);
+    sol::object next = lua.registry()[NEXT_TABLE][NEXT_KEY<T>];
+    return {next, sol::make_object(L, view), sol::make_object(L, sol::lua_nil)};
+}
+
+static std::string_view KeyName(const sol::stack_object& key) {
+    return key.get_type() == sol::type::string ? key.as<std::string_view>() : std::string_view();
+}
+
+// Lua index of array element, 0 for anything else
+static size_t KeyIndex(const sol::stack_object& key) {
+    return key.get_type() == sol::type::number ? key.as<size_t>() : 0;
+}
+
+static sol::object Nil(sol::this_state L) { return sol::make_object(L, sol::lua_nil); }
+
+template <typename T>
+static sol::object ArrayIndex(sol::this_state L, const ArrayView<T>& view,
+                              sol::stack_object key) {
+    const auto i = KeyIndex(key);
+    if (i < 1 || i > view.elements->size()) {
+        return Nil(L);
+    }
+    return sol::make_object(L, ElementView<T>{view.owner, &(*view.elements)[i - 1]});
+}
+
+template <typename T>
+static size_t ArrayLength(const ArrayView<T>& view) {
+    return view.elements->size();
+}
+
+template <typename T>
+static NextResult ArrayNext(sol::this_state L, const ArrayView<T>& view, sol::stack_object key) {
+    // Nil key starts iteration at first element
+    const auto i = KeyIndex(key);
+    if (i >= view.elements->size()) {
+        return {Nil(L), Nil(L)};
+    }
+    return {sol::make_object(L, i + 1),
+            sol::make_object(L, ElementView<T>{view.owner, &(*view.elements)[i]})};
+}
+
+static sol::object ApplicationIndex(sol::this_state L, const ElementView<Application>& view,
+                                    sol::stack_object key) {
+    const auto name = KeyName(key);
+    const auto& application = *view.element;
+    if (name == "name") return sol::make_object(L, application.name);
+    if (name == "focus") return sol::make_object(L, application.isFocused);
+    if (name == "alert") return sol::make_object(L, application.isAlerted);
+    if (name == "appid") return sol::make_object(L, application.appId);
+    return Nil(L);
+}
+
+static sol::object WorkspaceIndex(sol::this_state L, const ElementView<Workspace>& view,
+                                  sol::stack_object key) {
+    const auto name = KeyName(key);
+    const auto& workspace = *view.element;
+    if (name == "name") return sol::make_object(L, workspace.name);
+    if (name == "focus") return sol::make_object(L, workspace.isFocused);
+    if (name == "visible") return sol::make_object(L, workspace.isVisible);
+    if (name == "alert") return sol::make_object(L, workspace.isAlerted);
+    if (name == "applications") {
+        return sol::make_object(L, ArrayView<Application>{view.owner, &workspace.applications});
+    }
+    return Nil(L);
+}
+
+static sol::object DisplayIndex(sol::this_state L, const ElementView<Display>& view,
+                                sol::stack_object key) {
+    const auto name = KeyName(key);
+    const auto& display = *view.element;
+    if (name == "name") return sol::make_object(L, display.name);
+    if (name == "focus") return sol::make_object(L, display.isFocused);
+    if (name == "alert") return sol::make_object(L, display.isAlerted);
+    if (name == "workspaces") {
+        return sol::make_object(L, ArrayView<Workspace>{view.owner, &display.workspaces});
+    }
+    return Nil(L);
+}
+
+// Displays are keyed by name
+static sol::object DisplaysIndex(sol::this_state L, const RootView<Displays>& view,
+                                 sol::stack_object key) {
+    const auto name = KeyName(key);
+    const auto& displays = *view.slot;
+    for (const auto& display : *displays) {
+        if (display.name == name) {
+            return sol::make_object(L, ElementView<Display>{displays, &display});
+        }
+    }
+    return Nil(L);
+}
+
+static size_t DisplaysLength(const RootView<Displays>& view) { return (*view.slot)->size(); }
+
+static NextResult DisplaysNext(sol::this_state L, const RootView<Displays>& view,
+                               sol::stack_object key) {
+    const auto& displays = *view.slot;
+    auto it = displays->begin();
+    if (key.get_type() != sol::type::lua_nil) {
+        const auto name = KeyName(key);
+        it = std::find_if(displays->begin(), displays->end(),
+                          [&name](const auto& display) { return display.name == name; });
+        if (it != displays->end()) {
+            it++;
+        }
+    }
+    if (it == displays->end()) {
+        return {Nil(L), Nil(L)};
+    }
+    return {sol::make_object(L, it->name),
+            sol::make_object(L, ElementView<Display>{displays, &*it})};
+}
+
+static sol::object NetworkIndex(sol::this_state L, const NetworkView& view,
+                                sol::stack_object key) {
+    const auto name = KeyName(key);
+    const auto& network = view.network->second;
+    if (name == "up") return sol::make_object(L, network.isUp);
+    if (name == "interface") return sol::make_object(L, view.network->first);
+    if (name == "address") return sol::make_object(L, network.address);
+    return Nil(L);
+}
+
+// Networks are an array ordered by interface
+static sol::object NetworksIndex(sol::this_state L, const RootView<Networks>& view,
+                                 sol::stack_object key) {
+    const auto& networks = *view.slot;
+    const auto i = KeyIndex(key);
+    if (i < 1 || i > networks->size()) {
+        return Nil(L);
+    }
+    return sol::make_object(L, NetworkView{networks, &*std::next(networks->begin(), i - 1)});
+}
+
+static size_t NetworksLength(const RootView<Networks>& view) { return (*view.slot)->size(); }
+
+static NextResult NetworksNext(sol::this_state L, const RootView<Networks>& view,
+                               sol::stack_object key) {
+    const auto& networks = *view.slot;
+    const auto i = KeyIndex(key);
+    if (i >= networks->size()) {
+        return {Nil(L), Nil(L)};
+    }
+    return {sol::make_object(L, i + 1),
+            sol::make_object(L, NetworkView{networks, &*std::next(networks->begin(), i)})};
+}
+
+template <typename T>
+static void RegisterArray(sol::table& types, sol::table& next, const char* name) {
+    types.new_usertype<ArrayView<T>>(name, sol::no_constructor, sol::meta_function::index,
+                                     &ArrayIndex<T>, sol::meta_function::length,
+                                     &ArrayLength<T>, sol::meta_function::pairs,
+                                     &Pairs<T, ArrayView<T>>);
+    next[NEXT_KEY<T>] = &ArrayNext<T>;
+}
+
+void LazySources::Register(lua_State* L) {
+    sol::state_view lua(L);
+    // Kept in the registry instead of as globals
+    auto types = lua.create_table();
+    auto next = lua.create_table();
+    lua.registry()["zen.views"] = types;
+    lua.registry()[NEXT_TABLE] = next;
+    RegisterArray<Application>(types, next, "applications");
+    RegisterArray<Workspace>(types, next, "workspaces");
+    types.new_usertype<ElementView<Application>>("application", sol::no_constructor,
+                                                 sol::meta_function::index, &ApplicationIndex);
+    types.new_usertype<ElementView<Workspace>>("workspace", sol::no_constructor,
+                                               sol::meta_function::index, &WorkspaceIndex);
+    types.new_usertype<ElementView<Display>>("display", sol::no_constructor,
+                                             sol::meta_function::index, &DisplayIndex);
+    types.new_usertype<RootView<Displays>>(
+        "displays", sol::no_constructor, sol::meta_function::index, &DisplaysIndex,
+        sol::meta_function::length, &DisplaysLength, sol::meta_function::pairs,
+        &Pairs<Displays, RootView<Displays>>);
+    next[NEXT_KEY<Displays>] = &DisplaysNext;
+    types.new_usertype<NetworkView>("network", sol::no_constructor, sol::meta_function::index,
+                                    &NetworkIndex);
+    types.new_usertype<RootView<Networks>>(
+        "networks", sol::no_constructor, sol::meta_function::index, &NetworksIndex,
+        sol::meta_function::length, &NetworksLength, sol::meta_function::pairs,
+        &Pairs<Networks, RootView<Networks>>);
+    next[NEXT_KEY<Networks>] = &NetworksNext;
+}
+
+template <typename T>
+static void PublishSlot(lua_State* L,
+                        std::map<std::string, LazySources::Slot<T>, std::less<>>& slots,
+                        const std::string_view name, const T& state) {
+    // Sources keep mutating their state, so views need a copy of their own
+    auto snapshot = std::make_shared<const T>(state);
+    auto it = slots.find(name);
+    if (it != slots.end()) {
+        *it->second = std::move(snapshot);
+        return;
+    }
+    auto slot = std::make_shared<std::shared_ptr<const T>>(std::move(snapshot));
+    slots.emplace(std::string(name), slot);
+    sol::state_view lua(L);
+    lua["zen"][name] = RootView<T>{slot};
+}
+
+void LazySources::Publish(lua_State* L, const std::string_view name, const Displays& displays) {
+    PublishSlot(L, m_displays, name, displays);
+}
+
+void LazySources::Publish(lua_State* L, const std::string_view name, const Networks& networks) {
+    PublishSlot(L, m_networks, name, networks);
+}
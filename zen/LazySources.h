@@ -0,0 +1,31 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "zen/ScriptContext.h"
+
+struct lua_State;
+
+// Exposes source states to Lua as userdata that reads the native state on demand instead
+// of converting all of it into tables. Publishing copies the state once into a snapshot,
+// Lua pays for what it reads. Elements read from a view keep their snapshot alive.
+//
+// Takes the raw Lua state to keep sol2 out of headers.
+class LazySources {
+   public:
+    template <typename T>
+    using Slot = std::shared_ptr<std::shared_ptr<const T>>;
+
+    // Registers the view types, needed before publishing
+    static void Register(lua_State* L);
+    void Publish(lua_State* L, const std::string_view name, const Displays& displays);
+    void Publish(lua_State* L, const std::string_view name, const Networks& networks);
+
+   private:
+    // Views bound to zen.<name> read the current state through the slot
+    std::map<std::string, Slot<Displays>, std::less<>> m_displays;
+    std::map<std::string, Slot<Networks>, std::less<>> m_networks;
+};
@@ -0,0 +1,87 @@
+#include "zen/LuaAllocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+LuaAllocator::~LuaAllocator() {
+    for (auto chunk : m_chunks) {
+        free(chunk);
+    }
+}
+
+void* LuaAllocator::Allocate(size_t size) {
+    const auto sizeClass = ClassOf(size);
+    if (sizeClass == NUM_CLASSES) {
+        return malloc(size);
+    }
+    auto& head = m_free[sizeClass];
+    if (head) {
+        auto block = head;
+        head = block->next;
+        return block;
+    }
+    // Carve from the last chunk, the rest of a chunk too small is wasted
+    const auto classSize = (sizeClass + 1) * GRANULE;
+    if (m_left < classSize) {
+        // Malloc alignment is enough for any Lua object and sizes are multiples of it
+        auto chunk = static_cast<uint8_t*>(malloc(CHUNK_SIZE));
+        if (!chunk) {
+            return nullptr;
+        }
+        m_chunks.push_back(chunk);
+        m_next = chunk;
+        m_left = CHUNK_SIZE;
+    }
+    auto block = m_next;
+    m_next += classSize;
+    m_left -= classSize;
+    return block;
+}
+
+void LuaAllocator::Free(void* ptr, size_t size) {
+    if (!ptr) {
+        return;
+    }
+    const auto sizeClass = ClassOf(size);
+    if (sizeClass == NUM_CLASSES) {
+        free(ptr);
+        return;
+    }
+    auto block = static_cast<FreeBlock*>(ptr);
+    block->next = m_free[sizeClass];
+    m_free[sizeClass] = block;
+}
+
+void* LuaAllocator::Alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+    auto allocator = static_cast<LuaAllocator*>(ud);
+    // Size is a type tag when there is no block
+    if (!ptr) {
+        osize = 0;
+    }
+    if (nsize == 0) {
+        allocator->Free(ptr, osize);
+        return nullptr;
+    }
+    if (nsize > osize) {
+        allocator->m_allocated += nsize - osize;
+    }
+    if (ptr) {
+        const auto sizeClass = ClassOf(osize);
+        if (sizeClass == ClassOf(nsize)) {
+            // Fits in same block unless large
+            return sizeClass == NUM_CLASSES ? realloc(ptr, nsize) : ptr;
+        }
+    }
+    auto block = allocator->Allocate(nsize);
+    if (!block) {
+        // Lua requires shrinking to succeed, keep the larger block. It is later freed
+        // as the smaller size which only wastes the difference.
+        return nsize <= osize ? ptr : nullptr;
+    }
+    if (ptr) {
+        memcpy(block, ptr, std::min(osize, nsize));
+        allocator->Free(ptr, osize);
+    }
+    return block;
+}
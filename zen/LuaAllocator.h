@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lua allocator serving small blocks from size class free lists carved out of larger
+// chunks, larger blocks are passed on to malloc. Render functions create lots of short
+// lived strings and tables, those are recycled without going through malloc. Chunks are
+// kept until the allocator is destroyed.
+class LuaAllocator {
+   public:
+    LuaAllocator() {}
+    ~LuaAllocator();
+    LuaAllocator(const LuaAllocator&) = delete;
+    LuaAllocator& operator=(const LuaAllocator&) = delete;
+
+    // Matches lua_Alloc with the allocator as user data
+    static void* Alloc(void* ud, void* ptr, size_t osize, size_t nsize);
+    // Total number of bytes allocated so far, never decreases
+    uint64_t Allocated() const { return m_allocated; }
+    size_t ChunkBytes() const { return m_chunks.size() * CHUNK_SIZE; }
+
+    static constexpr size_t GRANULE = 16;
+    static constexpr size_t MAX_SMALL = 256;
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+   private:
+    static constexpr size_t NUM_CLASSES = MAX_SMALL / GRANULE;
+    // Blocks larger than MAX_SMALL are in class NUM_CLASSES
+    static size_t ClassOf(size_t size) {
+        return size <= MAX_SMALL ? (size - 1) / GRANULE : NUM_CLASSES;
+    }
+    void* Allocate(size_t size);
+    void Free(void* ptr, size_t size);
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    std::array<FreeBlock*, NUM_CLASSES> m_free{};
+    std::vector<void*> m_chunks;
+    uint8_t* m_next = nullptr;  // Unused part of last chunk
+    size_t m_left = 0;
+    uint64_t m_allocated = 0;
+};
@@ -0,0 +1,76 @@
+#include "zen/LuaFfi.h"
+
+// Strings are kept in a deque to keep pointers valid while more are added
+static zen_string Intern(std::deque<std::string>& strings, const std::string& s) {
+    const auto& interned = strings.emplace_back(s);
+    return zen_string{.data = interned.data(), .size = interned.size()};
+}
+
+void FfiPower::Update(const PowerState& power) {
+    root.isAlerted = power.IsAlerted;
+    root.isCharging = power.IsCharging;
+    root.isPluggedIn = power.IsPluggedIn;
+    root.capacity = power.Capacity;
+}
+
+void FfiAudio::Update(const AudioState& audio) {
+    port = audio.PortType;
+    root.muted = audio.Muted;
+    root.volume = audio.Volume;
+    root._port = zen_string{.data = port.data(), .size = port.size()};
+}
+
+void FfiNetworks::Update(const Networks& networks) {
+    items.clear();
+    strings.clear();
+    for (const auto& keyValue : networks) {
+        items.push_back(zen_network{.up = keyValue.second.isUp,
+                                    ._interface = Intern(strings, keyValue.first),
+                                    ._address = Intern(strings, keyValue.second.address)});
+    }
+    root.count = items.size();
+    root.items = items.data();
+}
+
+void FfiDisplays::Update(const Displays& source) {
+    displays.clear();
+    workspaces.clear();
+    applications.clear();
+    strings.clear();
+    // Flatten into one array per level, items are pointed out when all arrays are complete
+    for (const auto& display : source) {
+        displays.push_back(zen_display{
+            .focus = display.isFocused,
+            .alert = display.isAlerted,
+            ._name = Intern(strings, display.name),
+            .workspaces = {.count = (int32_t)display.workspaces.size(), .items = nullptr}});
+        for (const auto& workspace : display.workspaces) {
+            workspaces.push_back(zen_workspace{
+                .focus = workspace.isFocused,
+                .visible = workspace.isVisible,
+                .alert = workspace.isAlerted,
+                ._name = Intern(strings, workspace.name),
+                .applications = {.count = (int32_t)workspace.applications.size(),
+                                 .items = nullptr}});
+            for (const auto& application : workspace.applications) {
+                applications.push_back(zen_application{
+                    .focus = application.isFocused,
+                    .alert = application.isAlerted,
+                    ._name = Intern(strings, application.name),
+                    ._appid = Intern(strings, application.appId)});
+            }
+        }
+    }
+    size_t next = 0;
+    for (auto& display : displays) {
+        display.workspaces.items = workspaces.data() + next;
+        next += display.workspaces.count;
+    }
+    next = 0;
+    for (auto& workspace : workspaces) {
+        workspace.applications.items = applications.data() + next;
+        next += workspace.applications.count;
+    }
+    root.count = displays.size();
+    root.items = displays.data();
+}
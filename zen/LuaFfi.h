@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "zen/ScriptContext.h"
+
+// Source states in C layout for LuaJIT builds, read in place by Lua through the FFI
+// instead of being copied into tables. The declarations are stringified and handed to
+// ffi.cdef so that both sides always agree on the layout.
+//
+// Strings are prefixed with underscore, Lua gets them as Lua strings through the
+// metatypes set up in ScriptContext.cpp. Arrays are count and items.
+#define ZEN_FFI_DECLARE(...) \
+    __VA_ARGS__              \
+    static constexpr const char* FFI_DECLARATIONS = #__VA_ARGS__;
+
+ZEN_FFI_DECLARE(
+    struct zen_string {
+        const char* data;
+        size_t size;
+    };
+    struct zen_power {
+        bool isAlerted;
+        bool isCharging;
+        bool isPluggedIn;
+        int32_t capacity;
+    };
+    struct zen_audio {
+        bool muted;
+        float volume;
+        struct zen_string _port;
+    };
+    struct zen_network {
+        bool up;
+        struct zen_string _interface;
+        struct zen_string _address;
+    };
+    struct zen_networks {
+        int32_t count;
+        struct zen_network* items;
+    };
+    struct zen_application {
+        bool focus;
+        bool alert;
+        struct zen_string _name;
+        struct zen_string _appid;
+    };
+    struct zen_applications {
+        int32_t count;
+        struct zen_application* items;
+    };
+    struct zen_workspace {
+        bool focus;
+        bool visible;
+        bool alert;
+        struct zen_string _name;
+        struct zen_applications applications;
+    };
+    struct zen_workspaces {
+        int32_t count;
+        struct zen_workspace* items;
+    };
+    struct zen_display {
+        bool focus;
+        bool alert;
+        struct zen_string _name;
+        struct zen_workspaces workspaces;
+    };
+    struct zen_displays {
+        int32_t count;
+        struct zen_display* items;
+    };)
+
+// Each state owns everything its root points to. The root has a stable address for the
+// lifetime of the state, but arrays are rebuilt on update so Lua must not keep references
+// to elements between renders.
+struct FfiPower {
+    static constexpr const char* CTYPE = "struct zen_power";
+    void Update(const PowerState& power);
+
+    zen_power root{};
+};
+
+struct FfiAudio {
+    static constexpr const char* CTYPE = "struct zen_audio";
+    void Update(const AudioState& audio);
+
+    zen_audio root{};
+    std::string port;
+};
+
+struct FfiNetworks {
+    static constexpr const char* CTYPE = "struct zen_networks";
+    void Update(const Networks& networks);
+
+    zen_networks root{};
+    std::vector<zen_network> items;
+    std::deque<std::string> strings;
+};
+
+struct FfiDisplays {
+    static constexpr const char* CTYPE = "struct zen_displays";
+    void Update(const Displays& displays);
+
+    zen_displays root{};
+    std::vector<zen_display> displays;
+    std::vector<zen_workspace> workspaces;
+    std::vector<zen_application> applications;
+    std::deque<std::string> strings;
+};
@@ -0,0 +1,86 @@
+#include "zen/LuaWatchdog.h"
+
+#include <lua.hpp>
+
+#include "zen/Metrics.h"
+
+// Keeps raising errors until the call has ended, also when the error is caught in Lua
+static void Abort(lua_State* L, lua_Debug*) { luaL_error(L, "aborted, over callback budget"); }
+
+LuaWatchdog& LuaWatchdog::Shared() {
+    static LuaWatchdog watchdog;
+    return watchdog;
+}
+
+LuaWatchdog::~LuaWatchdog() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_changed.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+uint64_t LuaWatchdog::Begin(lua_State* L, std::chrono::microseconds budget) {
+    if (budget.count() <= 0) {
+        return 0;
+    }
+    const auto deadline = Clock::now() + budget;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_thread.joinable()) {
+        m_thread = std::thread(&LuaWatchdog::Watch, this);
+    }
+    const auto id = m_nextId++;
+    m_calls.emplace(id, Call{.L = L, .deadline = deadline, .isAborted = false});
+    // Calls in a row have later deadlines than the one already waited for
+    if (deadline < m_wakeAt) {
+        m_changed.notify_one();
+    }
+    return id;
+}
+
+bool LuaWatchdog::End(uint64_t id) {
+    if (id == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_calls.find(id);
+    if (it == m_calls.end()) {
+        return false;
+    }
+    const bool isAborted = it->second.isAborted;
+    if (isAborted) {
+        lua_sethook(it->second.L, nullptr, 0, 0);
+        Metrics::Shared().Add("lua.overruns");
+    }
+    m_calls.erase(it);
+    return isAborted;
+}
+
+void LuaWatchdog::Watch() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_isStopping) {
+        const auto now = Clock::now();
+        m_wakeAt = Clock::time_point::max();
+        for (auto& keyValue : m_calls) {
+            auto& call = keyValue.second;
+            if (call.isAborted) {
+                continue;
+            }
+            if (call.deadline <= now) {
+                // Setting hooks is safe while the state is running
+                lua_sethook(call.L, Abort, LUA_MASKCOUNT, 1);
+                call.isAborted = true;
+                continue;
+            }
+            m_wakeAt = std::min(m_wakeAt, call.deadline);
+        }
+        if (m_wakeAt == Clock::time_point::max()) {
+            m_changed.wait(lock);
+        } else {
+            m_changed.wait_until(lock, m_wakeAt);
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+
+struct lua_State;
+
+// Aborts calls into Lua that run longer than their budget, so that a looping callback
+// can not block the main loop. A thread waits for the deadline of the calls in progress
+// and sets a count hook in the state of a call that is over, the hook raises an error on
+// the next instruction. No hook is set while calls are within budget.
+//
+// C functions, like a blocking io.popen, are only aborted once they return to Lua. The hook
+// is set on the main thread of the state, coroutines are not aborted. LuaJIT does not run
+// hooks in compiled code, only calls to interpreted functions are aborted there.
+class LuaWatchdog {
+   public:
+    static LuaWatchdog& Shared();
+    ~LuaWatchdog();
+
+    // Starts watching a call, returns id to end it with. Zero budget is not watched and 0
+    // is returned.
+    uint64_t Begin(lua_State* L, std::chrono::microseconds budget);
+    // Returns true if the call was aborted
+    bool End(uint64_t id);
+
+   private:
+    using Clock = std::chrono::steady_clock;
+    struct Call {
+        lua_State* L;
+        Clock::time_point deadline;
+        bool isAborted;
+    };
+
+    LuaWatchdog() : m_nextId(1), m_wakeAt(Clock::time_point::max()), m_isStopping(false) {}
+    void Watch();
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::map<uint64_t, Call> m_calls;
+    uint64_t m_nextId;
+    Clock::time_point m_wakeAt;  // When watching thread wakes up next
+    bool m_isStopping;
+    std::thread m_thread;
+};
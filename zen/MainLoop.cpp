@@ -16,24 +16,27 @@ void MainLoop::Run() {
     // Register internal events
     m_polls.push_back(pollfd{.fd = m_wakeupFd, .events = POLLIN, .revents = 0});
 
+    bool isIdlePending = false;
     do {
         // Should be ppoll
-        int num = poll(m_polls.data(), m_polls.size(), -1);
+        int num = poll(m_polls.data(), m_polls.size(), isIdlePending ? IDLE_DELAY_MS : -1);
         if (num < 0) {
             // Error!
             spdlog::error("Poll error in main loop");
             break;
         }
         if (num == 0) {
-            // Timeout
-            spdlog::error("Timeout in main loop");
+            // Idle
+            isIdlePending = m_handler && m_handler->OnIdle();
             continue;
         }
         // Process
         spdlog::trace("{} events in main loop", num);
         bool anyDirty = false;
-        for (auto& poll : m_polls) {
-            if ((poll.events & poll.revents) != 0) {
+        // Handlers might register and unregister, index as polls might be reallocated
+        for (size_t i = 0; i < m_polls.size(); i++) {
+            const auto poll = m_polls[i];
+            if (poll.fd >= 0 && (poll.events & poll.revents) != 0) {
                 // Special treatment on internal events. Empty events and
                 // rely on batch processing when all other events has been processed
                 if (poll.fd == m_wakeupFd) {
@@ -45,19 +48,27 @@ void MainLoop::Run() {
                     // For now internal events always means that a source is dirty
                     anyDirty = true;
                 } else {
-                    auto& handler = m_handlers[poll.fd];
+                    // Keep alive while invoked in case it unregisters itself
+                    auto handler = m_handlers[poll.fd];
                     spdlog::trace("Invoking io handler for fd {}", poll.fd);
                     anyDirty = handler->OnRead() || anyDirty;
                     spdlog::trace("Io handler done");
                 }
             }
         }
+        std::erase_if(m_polls, [](const pollfd& poll) { return poll.fd < 0; });
         if (anyDirty && m_handler) {
             m_handler->OnChanged();
+            isIdlePending = true;
         }
-        if (m_alerted) {
-            m_handler->OnAlerted();
-            m_alerted = false;
+        std::vector<AlertEvent> alertEvents;
+        {
+            std::lock_guard<std::mutex> lock(m_alertMutex);
+            alertEvents.swap(m_alertEvents);
+        }
+        if (!alertEvents.empty() && m_handler) {
+            m_handler->OnAlerted(alertEvents);
+            isIdlePending = true;
         }
     } while (m_polls.size() > 0);
 }
@@ -69,6 +80,17 @@ void MainLoop::RegisterIoHandler(int fd, const std::string_view name,
     spdlog::debug("Registering {} in main loop for fd {}", name, fd);
 }
 
+void MainLoop::UnregisterIoHandler(int fd) {
+    // Polls are removed after the current batch, negative fds are ignored by poll
+    for (auto& poll : m_polls) {
+        if (poll.fd == fd) {
+            poll.fd = -1;
+        }
+    }
+    m_handlers.erase(fd);
+    spdlog::debug("Unregistering fd {} from main loop", fd);
+}
+
 void MainLoop::RegisterNotificationHandler(std::shared_ptr<NotificationHandler> batchHandler) {
     if (m_handler) {
         spdlog::error("Only one batch handler supported");
@@ -83,7 +105,20 @@ void MainLoop::Wakeup() {
     m_wakupMutex.unlock();
 }
 
-void MainLoop::AlertAndWakeup() {
-    m_alerted = true;
+void MainLoop::AlertAndWakeup(Alert alert) {
+    {
+        std::lock_guard<std::mutex> lock(m_alertMutex);
+        m_alertEvents.push_back(AlertEvent{.isRaised = true, .alert = std::move(alert)});
+    }
+    Wakeup();
+}
+
+void MainLoop::ClearAlertAndWakeup(AlertKind kind, const std::string& id) {
+    {
+        std::lock_guard<std::mutex> lock(m_alertMutex);
+        m_alertEvents.push_back(AlertEvent{
+            .isRaised = false,
+            .alert = Alert{.kind = kind, .priority = AlertPriority::Low, .id = id, .message = ""}});
+    }
     Wakeup();
 }
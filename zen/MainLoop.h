@@ -2,12 +2,14 @@
 
 #include <poll.h>
 
-#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
+
+#include "zen/Alert.h"
 
 class IoHandler {
    public:
@@ -18,7 +20,10 @@ class IoHandler {
 class NotificationHandler {
    public:
     virtual void OnChanged() = 0;
-    virtual void OnAlerted() = 0;
+    virtual void OnAlerted(const std::vector<AlertEvent>& events) = 0;
+    // Invoked when nothing has happened for a while after a batch, return true to be
+    // invoked again when still idle.
+    virtual bool OnIdle() { return false; }
 };
 
 class MainLoop {
@@ -28,20 +33,27 @@ class MainLoop {
     void Run();
     void RegisterIoHandler(int fd, const std::string_view name,
                            std::shared_ptr<IoHandler> ioHandler);
+    // Safe to call from io handlers, also for the fd being handled. Does not close fd.
+    void UnregisterIoHandler(int fd);
     void RegisterNotificationHandler(std::shared_ptr<NotificationHandler> ioBatchHandler);
     // In cases where polling for events is done on another thread that thread should
     // call this to trigger dirty check on all registered io handlers.
     // Or in cases where source gets dirty due to some other type of event than io.
     void Wakeup();
 
-    void AlertAndWakeup();
+    // Alerts are handled in next batch after sources has been read
+    void AlertAndWakeup(Alert alert);
+    void ClearAlertAndWakeup(AlertKind kind, const std::string& id);
 
    private:
+    // Quiet time after a batch before idle handling
+    static constexpr int IDLE_DELAY_MS = 5;
     MainLoop(int eventFd) : m_wakeupFd(eventFd) {}
 
     int m_wakeupFd;
     std::mutex m_wakupMutex;
-    std::atomic<bool> m_alerted;
+    std::mutex m_alertMutex;
+    std::vector<AlertEvent> m_alertEvents;
     std::vector<pollfd> m_polls;
     std::map<int, std::shared_ptr<IoHandler>> m_handlers;
     std::shared_ptr<NotificationHandler> m_handler;
@@ -3,8 +3,9 @@
 #include "spdlog/spdlog.h"
 #include "zen/Registry.h"
 
-std::shared_ptr<Manager> Manager::Create(std::shared_ptr<Registry> registry) {
-    auto manager = std::shared_ptr<Manager>(new Manager(registry));
+std::shared_ptr<Manager> Manager::Create(std::shared_ptr<Registry> registry,
+                                         std::shared_ptr<AlertSource> alerts) {
+    auto manager = std::shared_ptr<Manager>(new Manager(registry, alerts));
     // Register click handler
     if (!registry->seat) {
         spdlog::error("No seat in registry");
@@ -34,9 +35,12 @@ void Manager::OnChanged() {
         m_visibilityChanged = false;
         if (m_isVisible) {
             m_sources->ForceRedraw();
-            if (m_alerted) {
+            if (!m_alerts->IsEmpty()) {
+                // User has seen the overlay, consider alerts acknowledged
+                m_alerts->Clear();
+                m_sources->PublishAll();
                 m_registry->BorrowOutputs().HideAlert(*m_registry);
-                m_alerted = false;
+                m_drawnAlerts = m_alerts->Generation();
             }
         } else {
             m_registry->BorrowOutputs().Hide(*m_registry);
@@ -45,13 +49,56 @@ void Manager::OnChanged() {
     if (m_isVisible) {
         m_registry->BorrowOutputs().Draw(*m_registry, *m_sources);
         m_sources->SetAllDrawn();
-    } else if (m_alerted) {
-        m_registry->BorrowOutputs().DrawAlert(*m_registry);
+        // Frame is committed, keep up with the garbage of rendering it
+        m_sources->CollectGarbage(GC_STEP_BUDGET);
+    } else if (m_alerts->Generation() != m_drawnAlerts) {
+        // Alert panel is only rendered when the set of alerts changes, the compositor
+        // keeps showing the last committed buffer in between.
+        m_drawnAlerts = m_alerts->Generation();
+        if (m_alerts->IsEmpty()) {
+            m_registry->BorrowOutputs().HideAlert(*m_registry);
+        } else {
+            m_registry->BorrowOutputs().DrawAlert(*m_registry);
+        }
+    }
+}
+
+bool Manager::OnIdle() {
+    return m_sources && m_sources->CollectGarbage(GC_STEP_BUDGET);
+}
+
+void Manager::OnAlerted(const std::vector<AlertEvent>& events) {
+    if (m_alerts->Apply(events)) {
+        OnChanged();
     }
 }
 
-void Manager::OnAlerted() {
-    m_alerted = true;
+void Manager::Reconfigure(
+    std::shared_ptr<Configuration> config, std::unique_ptr<ScriptContext> scriptContext,
+    const std::function<void(const std::string& source, Sources& sources)>& initializeSource) {
+    // Surfaces release the callbacks into the previous script context before it is destroyed
+    if (!m_registry->BorrowOutputs().Reconfigure(*m_registry, config)) {
+        spdlog::error("Failed to reconfigure outputs");
+    }
+    m_sources->SetScriptContext(std::move(scriptContext));
+    m_alerts->Reconfigure(config->alerts);
+    auto panelConfigs = config->panels;
+    panelConfigs.push_back(config->alertPanel);
+    std::set<std::string> used;
+    for (const auto& panelConfig : panelConfigs) {
+        for (const auto& widgetConfig : panelConfig.widgets) {
+            used.insert(widgetConfig.sources.begin(), widgetConfig.sources.end());
+        }
+    }
+    for (const auto& source : used) {
+        // Sources defined in configuration are restarted with the reloaded poll function
+        if (!m_sources->IsRegistered(source) || config->luaSources.contains(source)) {
+            spdlog::info("Starting source {} for reloaded configuration", source);
+            initializeSource(source, *m_sources);
+        }
+    }
+    // Alert panel is drawn again if there are alerts
+    m_drawnAlerts = m_alerts->Generation() + 1;
     OnChanged();
 }
 
@@ -3,18 +3,29 @@
 #include "zen/MainLoop.h"
 #include "zen/Output.h"
 #include "zen/ScriptContext.h"
+#include "zen/Sources/AlertSource.h"
 #include "zen/Sources/Sources.h"
 
 class Manager : public NotificationHandler {
    public:
-    static std::shared_ptr<Manager> Create(std::shared_ptr<Registry> registry);
+    static std::shared_ptr<Manager> Create(std::shared_ptr<Registry> registry,
+                                           std::shared_ptr<AlertSource> alerts);
     void SetSources(std::unique_ptr<Sources> sources) { m_sources = std::move(sources); }
     virtual ~Manager() {}
     // When a batch of IO events has been processed and sources needs to be published and/or needs
     // to redrawn
     void OnChanged() override;
 
-    void OnAlerted() override;
+    void OnAlerted(const std::vector<AlertEvent>& events) override;
+    // Collects Lua garbage in small steps, never while drawing
+    bool OnIdle() override;
+
+    // Replaces configuration with one reloaded in scriptContext. Surfaces of panels still
+    // configured and running sources are kept, initializeSource is invoked for sources not
+    // yet registered and for sources defined in configuration.
+    void Reconfigure(
+        std::shared_ptr<Configuration> config, std::unique_ptr<ScriptContext> scriptContext,
+        const std::function<void(const std::string& source, Sources& sources)>& initializeSource);
 
     // Compositors tells manager when the overlays should be visible
     void Show();
@@ -24,12 +35,19 @@ class Manager : public NotificationHandler {
     void WheelSurface(wl_surface* surface, int x, int y, int value);
 
    private:
-    Manager(std::shared_ptr<Registry> registry)
-        : m_registry(registry), m_isVisible(false), m_visibilityChanged(false), m_alerted(false) {}
+    static constexpr std::chrono::microseconds GC_STEP_BUDGET{1000};
+
+    Manager(std::shared_ptr<Registry> registry, std::shared_ptr<AlertSource> alerts)
+        : m_registry(registry),
+          m_isVisible(false),
+          m_visibilityChanged(false),
+          m_alerts(alerts),
+          m_drawnAlerts(0) {}
 
     std::shared_ptr<Registry> m_registry;
     bool m_isVisible;
     bool m_visibilityChanged;
     std::unique_ptr<Sources> m_sources;
-    bool m_alerted;
+    std::shared_ptr<AlertSource> m_alerts;
+    uint64_t m_drawnAlerts;  // Generation of alerts currently drawn
 };
@@ -0,0 +1,6 @@
+#include "zen/Metrics.h"
+
+Metrics& Metrics::Shared() {
+    static Metrics metrics;
+    return metrics;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Process wide counters and gauges, for diagnosing performance. Updated from render workers.
+class Metrics {
+   public:
+    static Metrics& Shared();
+
+    // Counters
+    void Add(const std::string& name, int64_t n = 1) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_values[name] += n;
+    }
+    // Gauges
+    void Set(const std::string& name, int64_t value) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_values[name] = value;
+    }
+    int64_t Get(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_values.find(name);
+        return it != m_values.end() ? it->second : 0;
+    }
+    std::map<std::string, int64_t> All() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_values;
+    }
+
+   private:
+    Metrics() {}
+    mutable std::mutex m_mutex;
+    std::map<std::string, int64_t> m_values;
+};
@@ -1,17 +1,20 @@
 #include "Output.h"
 
+#include <algorithm>
+
 #include "Registry.h"
 #include "ShellSurface.h"
 #include "spdlog/spdlog.h"
+#include "zen/LayoutCache.h"
 
 class Output {
     using OnNamedCallback = std::function<void(Output *output, const std::string &name)>;
 
    public:
     static void Create(wl_output *wloutput, const wl_output_listener *listener,
-                       std::shared_ptr<Configuration> config, OnNamedCallback onNamed) {
+                       OnNamedCallback onNamed) {
         // This will be in lingo until name is received
-        auto output = new Output(wloutput, config, onNamed);
+        auto output = new Output(wloutput, onNamed);
         wl_output_add_listener(wloutput, listener, output);
     }
 
@@ -22,6 +25,8 @@ class Output {
         m_onNamed = nullptr;
     }
 
+    wl_output *WlOutput() const { return m_wloutput; }
+
     void OnDescription(const char * /*description*/) {
         // Might change over lifetime
     }
@@ -31,11 +36,17 @@ class Output {
         m_wloutput = nullptr;
     }
 
-    void Draw(const Registry &registry, const PanelConfig &panelConfig, BufferPool &bufferPool) {
-        // Query panel if it wants to be drawn on this display
-        if (panelConfig.checkDisplay && !panelConfig.checkDisplay(m_name)) {
-            return;
-        }
+    // Query panel if it wants to be drawn on this display
+    bool Shows(const PanelConfig &panelConfig) const {
+        return !panelConfig.checkDisplay || panelConfig.checkDisplay(m_name);
+    }
+
+    const std::string &Name() const { return m_name; }
+
+    // Widgets in prerendered are used instead of rendering them while drawing
+    void Draw(const Registry &registry, const PanelConfig &panelConfig, BufferPool &bufferPool,
+              const std::vector<bool> &dirtyWidgets,
+              std::vector<std::unique_ptr<Renderable>> prerendered) {
         spdlog::info("Drawing panel {} on output {}", panelConfig.index, m_name);
         // Ensure that there is a surface for this panel
         if (!m_surfaces.contains(panelConfig.index)) {
@@ -46,15 +57,48 @@ class Output {
             }
             m_surfaces[panelConfig.index] = std::move(surface);
         }
-        m_surfaces[panelConfig.index]->Draw(registry, bufferPool, m_name);
+        auto &surface = m_surfaces[panelConfig.index];
+        surface->SetPrerendered(std::move(prerendered));
+        surface->Draw(bufferPool, m_name, dirtyWidgets);
     }
 
-    void Hide(const Registry &registry) {
+    // Panel was dirty but not drawn on this output, widgets must not be reused when the
+    // panel is drawn here again
+    void SkipDraw(const PanelConfig &panelConfig) {
+        auto it = m_surfaces.find(panelConfig.index);
+        if (it != m_surfaces.end()) {
+            it->second->Invalidate();
+        }
+    }
+
+    void Hide() {
         for (const auto &kv : m_surfaces) {
-            kv.second->Hide(registry);
+            kv.second->Hide();
+        }
+    }
+
+    // Surfaces of panels still in configuration are kept, they apply anchor and size each
+    // time drawn. Surfaces of removed panels are destroyed.
+    void Reconfigure(const Configuration &config) {
+        for (auto it = m_surfaces.begin(); it != m_surfaces.end();) {
+            const auto index = it->first;
+            auto panelConfig = std::find_if(config.panels.begin(), config.panels.end(),
+                                            [index](const auto &p) { return p.index == index; });
+            if (index == config.alertPanel.index) {
+                it->second->Reconfigure(config.alertPanel);
+            } else if (panelConfig != config.panels.end()) {
+                it->second->Reconfigure(*panelConfig);
+            } else {
+                spdlog::info("Removing panel {} from output {}", index, m_name);
+                it = m_surfaces.erase(it);
+                continue;
+            }
+            ++it;
         }
     }
 
+    void DestroySurfaces() { m_surfaces.clear(); }
+
     bool ClickSurface(wl_surface *surface, int x, int y) {
         for (auto &kv : m_surfaces) {
             if (kv.second->ClickSurface(surface, x, y)) {
@@ -78,12 +122,11 @@ class Output {
     }
 
    private:
-    Output(wl_output *wloutput, std::shared_ptr<Configuration> config, OnNamedCallback onNamed)
-        : m_wloutput(wloutput), m_config(config), m_onNamed(onNamed) {}
+    Output(wl_output *wloutput, OnNamedCallback onNamed)
+        : m_wloutput(wloutput), m_onNamed(onNamed) {}
 
     std::map<int, std::unique_ptr<ShellSurface>> m_surfaces;  // Surface per panel index
     wl_output *m_wloutput;
-    const std::shared_ptr<Configuration> m_config;
     // Temporary callback until named, registers amoung the other outputs when name received
     OnNamedCallback m_onNamed;
     std::string m_name;
@@ -118,7 +161,17 @@ const struct wl_output_listener listener = {
 };
 
 std::unique_ptr<Outputs> Outputs::Create(std::shared_ptr<Configuration> config) {
-    return std::unique_ptr<Outputs>(new Outputs(config));
+    auto outputs = std::unique_ptr<Outputs>(new Outputs(config));
+    outputs->StartRenderPool();
+    return outputs;
+}
+
+void Outputs::StartRenderPool() {
+    const int numWorkers = m_config->renderWorkers;
+    if (m_renderPool && m_renderPool->NumWorkers() == numWorkers) {
+        return;
+    }
+    m_renderPool = numWorkers > 1 ? RenderPool::Create(numWorkers) : nullptr;
 }
 
 bool Outputs::InitializeBuffers(wl_shm &shm) {
@@ -132,48 +185,120 @@ bool Outputs::InitializeBuffers(wl_shm &shm) {
 }
 
 void Outputs::Add(wl_output *wloutput) {
-    Output::Create(wloutput, &listener, m_config, [this](auto output, auto name) {
+    Output::Create(wloutput, &listener, [this](auto output, auto name) {
         spdlog::info("Adding output {}", name);
         m_map[name] = std::shared_ptr<Output>(output);
     });
 }
 
+wl_output *Outputs::Find(const std::string &name) const {
+    auto it = m_map.find(name);
+    return it != m_map.end() ? it->second->WlOutput() : nullptr;
+}
+
+bool Outputs::Reconfigure(const Registry &registry, std::shared_ptr<Configuration> config) {
+    const bool isSameBuffers = config->numBuffers == m_config->numBuffers &&
+                               config->bufferWidth == m_config->bufferWidth &&
+                               config->bufferHeight == m_config->bufferHeight;
+    m_config = config;
+    StartRenderPool();
+    if (isSameBuffers) {
+        for (auto &nameAndOutput : m_map) {
+            nameAndOutput.second->Reconfigure(*m_config);
+        }
+        return true;
+    }
+    // Surfaces might hold buffers from the pool being replaced
+    spdlog::info("Buffers changed, recreating all panels");
+    for (auto &nameAndOutput : m_map) {
+        nameAndOutput.second->DestroySurfaces();
+    }
+    return InitializeBuffers(*registry.Shm());
+}
+
 void Outputs::Draw(const Registry &registry, const Sources &sources) {
     spdlog::trace("Draw outputs");
+    bool anyDirty = false;
+    std::vector<PanelDraw> draws;
     for (const auto &panelConfig : m_config->panels) {
+        // Track dirtiness per widget to only render widgets whose sources changed
         bool dirty = false;
-        for (const auto &widgetConfig : panelConfig.widgets) {
-            if (sources.NeedsRedraw(widgetConfig.sources)) {
-                dirty = true;
-                break;
-            }
+        std::vector<bool> dirtyWidgets(panelConfig.widgets.size());
+        for (size_t i = 0; i < panelConfig.widgets.size(); i++) {
+            const auto &widget = panelConfig.widgets[i];
+            dirtyWidgets[i] = sources.NeedsRedraw(widget.sources) ||
+                              (widget.isBackedOff && widget.isBackedOff());
+            dirty = dirty || dirtyWidgets[i];
         }
         // This panel is dirty, redraw it on every output
         if (dirty) {
+            anyDirty = true;
             for (const auto &nameAndOutput : m_map) {
-                nameAndOutput.second->Draw(registry, panelConfig, *m_bufferPool);
+                if (nameAndOutput.second->Shows(panelConfig)) {
+                    draws.push_back(PanelDraw{.output = nameAndOutput.second.get(),
+                                              .panelConfig = &panelConfig,
+                                              .dirtyWidgets = dirtyWidgets,
+                                              .prerendered = {}});
+                } else {
+                    nameAndOutput.second->SkipDraw(panelConfig);
+                }
             }
         }
     }
+    Prerender(draws);
+    for (auto &draw : draws) {
+        draw.output->Draw(registry, *draw.panelConfig, *m_bufferPool, draw.dirtyWidgets,
+                          std::move(draw.prerendered));
+    }
+    // Only count generations where something was drawn, layouts of panels that seldom
+    // changes should not be evicted by unrelated updates.
+    if (anyDirty) {
+        LayoutCache::Shared().EndGeneration();
+    }
+}
+
+// Dirty widgets of every panel and output are rendered in parallel, one job per panel
+// and output. Each job renders its widgets in order, like when drawing.
+void Outputs::Prerender(std::vector<PanelDraw> &draws) {
+    if (!m_renderPool || draws.size() < 2) {
+        return;
+    }
+    std::vector<std::function<void()>> jobs;
+    for (auto &draw : draws) {
+        jobs.push_back([&draw] {
+            const auto &widgets = draw.panelConfig->widgets;
+            draw.prerendered.resize(widgets.size());
+            for (size_t i = 0; i < widgets.size(); i++) {
+                if (draw.dirtyWidgets[i]) {
+                    draw.prerendered[i] = widgets[i].render(draw.output->Name());
+                }
+            }
+        });
+    }
+    m_renderPool->Run(jobs);
 }
 
-void Outputs::Hide(const Registry &registry) {
+void Outputs::Hide(const Registry &) {
     for (auto &keyValue : m_map) {
-        keyValue.second->Hide(registry);
+        keyValue.second->Hide();
     }
 }
 
 void Outputs::DrawAlert(const Registry &registry) {
     spdlog::info("Draw alert");
     for (const auto &nameAndOutput : m_map) {
-        nameAndOutput.second->Draw(registry, m_config->alertPanel, *m_bufferPool);
+        // Alert panel is drawn when alerts change, always render all widgets
+        if (nameAndOutput.second->Shows(m_config->alertPanel)) {
+            nameAndOutput.second->Draw(registry, m_config->alertPanel, *m_bufferPool, {}, {});
+        }
     }
+    LayoutCache::Shared().EndGeneration();
 }
 
-void Outputs::HideAlert(const Registry &registry) {
+void Outputs::HideAlert(const Registry &) {
     spdlog::info("Hide alert");
     for (const auto &nameAndOutput : m_map) {
-        nameAndOutput.second->Hide(registry);
+        nameAndOutput.second->Hide();
     }
 }
 
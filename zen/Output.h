@@ -9,6 +9,7 @@
 
 #include "zen/Buffer.h"
 #include "zen/Configuration.h"
+#include "zen/RenderPool.h"
 #include "zen/Sources/Sources.h"
 
 class Output;
@@ -19,7 +20,11 @@ class Outputs {
    public:
     static std::unique_ptr<Outputs> Create(std::shared_ptr<Configuration> config);
     bool InitializeBuffers(wl_shm&);
+    // Replaces configuration when reloaded, keeps surfaces of panels still configured
+    bool Reconfigure(const Registry& registry, std::shared_ptr<Configuration> config);
     void Add(wl_output* output);
+    // Null if no output with name
+    wl_output* Find(const std::string& name) const;
 
     void Draw(const Registry& registry, const Sources& sources);
     void Hide(const Registry& registry);
@@ -30,8 +35,21 @@ class Outputs {
     void WheelSurface(wl_surface* surface, int x, int y, int value);
 
    private:
+    // Panel to draw on an output
+    struct PanelDraw {
+        Output* output;
+        const PanelConfig* panelConfig;
+        std::vector<bool> dirtyWidgets;
+        std::vector<std::unique_ptr<Renderable>> prerendered;
+    };
+
     Outputs(std::shared_ptr<Configuration> config) : m_config(config) {}
+    // Pool for configurations with render workers
+    void StartRenderPool();
+    void Prerender(std::vector<PanelDraw>& draws);
+
     std::map<std::string, std::shared_ptr<Output>> m_map;
-    const std::shared_ptr<Configuration> m_config;
+    std::shared_ptr<Configuration> m_config;
     std::unique_ptr<BufferPool> m_bufferPool;
+    std::unique_ptr<RenderPool> m_renderPool;
 };
@@ -0,0 +1,148 @@
+#include "zen/Process.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <spdlog/spdlog.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstring>
+
+extern char** environ;
+
+// Not wrapped by older C libraries
+static int PidfdOpen(pid_t pid) { return syscall(SYS_pidfd_open, pid, 0); }
+
+std::shared_ptr<Process> Process::Spawn(std::shared_ptr<MainLoop> mainLoop,
+                                        const std::vector<std::string>& argv,
+                                        Callbacks callbacks) {
+    if (argv.empty()) {
+        spdlog::error("No program to spawn");
+        return nullptr;
+    }
+    int pipefds[2] = {-1, -1};
+    if (callbacks.onOutput && pipe2(pipefds, O_CLOEXEC | O_NONBLOCK) == -1) {
+        spdlog::error("Failed to create pipe for {}: {}", argv[0], strerror(errno));
+        return nullptr;
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    // Never let children read input meant for zenway
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    if (pipefds[1] != -1) {
+        // Duplicated fd does not inherit close on exec
+        posix_spawn_file_actions_adddup2(&actions, pipefds[1], STDOUT_FILENO);
+    }
+    std::vector<char*> args;
+    for (const auto& arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+    // Signals blocked by zenway, like SIGUSR1, would otherwise be blocked in children too.
+    // Children writing output after zenway closed the pipe should be killed by SIGPIPE.
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attr, &signals);
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &signals);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+    pid_t pid;
+    const auto error = posix_spawnp(&pid, args[0], &actions, &attr, args.data(), environ);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    if (pipefds[1] != -1) {
+        close(pipefds[1]);
+    }
+    if (error != 0) {
+        spdlog::error("Failed to spawn {}: {}", argv[0], strerror(error));
+        if (pipefds[0] != -1) close(pipefds[0]);
+        return nullptr;
+    }
+    const auto pidfd = PidfdOpen(pid);
+    if (pidfd == -1) {
+        // Process is running but can not be waited for without blocking
+        spdlog::error("Failed to open pidfd for {}: {}", argv[0], strerror(errno));
+        if (pipefds[0] != -1) close(pipefds[0]);
+        return nullptr;
+    }
+    spdlog::debug("Spawned {} as {}", argv[0], pid);
+    auto process = std::shared_ptr<Process>(
+        new Process(mainLoop, pid, pidfd, pipefds[0], std::move(callbacks)));
+    mainLoop->RegisterIoHandler(pidfd, "Process", process);
+    if (pipefds[0] != -1) {
+        mainLoop->RegisterIoHandler(pipefds[0], "Process", process);
+    }
+    return process;
+}
+
+Process::~Process() {
+    CloseOutput();
+    if (m_pidfd != -1) close(m_pidfd);
+}
+
+bool Process::ReadOutput() {
+    char buffer[4096];
+    ssize_t n;
+    bool anyLine = false;
+    while ((n = read(m_outputfd, buffer, sizeof(buffer))) > 0) {
+        m_partialLine.append(buffer, n);
+        size_t start = 0;
+        size_t end;
+        while ((end = m_partialLine.find('\n', start)) != std::string::npos) {
+            m_callbacks.onOutput(std::string_view(m_partialLine).substr(start, end - start));
+            anyLine = true;
+            start = end + 1;
+        }
+        m_partialLine.erase(0, start);
+    }
+    if (n == 0) {
+        // End of output, process might still be running
+        CloseOutput();
+    }
+    return anyLine;
+}
+
+void Process::CloseOutput() {
+    if (m_outputfd == -1) return;
+    m_mainLoop->UnregisterIoHandler(m_outputfd);
+    close(m_outputfd);
+    m_outputfd = -1;
+}
+
+// Dirty when any callback was invoked, callbacks might have changed what is rendered
+bool Process::OnRead() {
+    bool invoked = false;
+    // Registered for both, either might be ready
+    if (m_outputfd != -1) {
+        invoked = ReadOutput();
+    }
+    siginfo_t info{};
+    if (m_pidfd == -1 || waitid(P_PID, m_pid, &info, WEXITED | WNOHANG) == -1 ||
+        info.si_pid == 0) {
+        return invoked;
+    }
+    // Exited, read what is left and flush the last line even when not terminated
+    if (m_outputfd != -1) {
+        invoked = ReadOutput() || invoked;
+        CloseOutput();
+    }
+    if (!m_partialLine.empty()) {
+        m_callbacks.onOutput(m_partialLine);
+        m_partialLine.clear();
+        invoked = true;
+    }
+    m_mainLoop->UnregisterIoHandler(m_pidfd);
+    close(m_pidfd);
+    m_pidfd = -1;
+    const int status = info.si_code == CLD_EXITED ? info.si_status : 128 + info.si_status;
+    spdlog::debug("Process {} exited with {}", m_pid, status);
+    if (m_callbacks.onExit) {
+        m_callbacks.onExit(status);
+        invoked = true;
+    }
+    return invoked;
+}
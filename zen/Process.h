@@ -0,0 +1,53 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "zen/MainLoop.h"
+
+// Child process started without blocking the main loop. Output is captured through a
+// pipe and delivered line by line, the exit status once the process has exited. Both
+// are invoked on the main loop. Processes are always reaped, callbacks are optional.
+class Process : public IoHandler {
+   public:
+    struct Callbacks {
+        // Captures stdout when set, otherwise it is inherited
+        std::function<void(std::string_view line)> onOutput;
+        // Exit code, or 128 + signal number when killed
+        std::function<void(int status)> onExit;
+    };
+
+    // Searches PATH for argv[0] like execvp. Returns nullptr if the process could not be
+    // started.
+    static std::shared_ptr<Process> Spawn(std::shared_ptr<MainLoop> mainLoop,
+                                          const std::vector<std::string>& argv,
+                                          Callbacks callbacks);
+    virtual ~Process();
+
+    bool OnRead() override;
+    pid_t Pid() const { return m_pid; }
+
+   private:
+    Process(std::shared_ptr<MainLoop> mainLoop, pid_t pid, int pidfd, int outputfd,
+            Callbacks callbacks)
+        : m_mainLoop(mainLoop),
+          m_pid(pid),
+          m_pidfd(pidfd),
+          m_outputfd(outputfd),
+          m_callbacks(std::move(callbacks)) {}
+    // Returns true if any line was delivered
+    bool ReadOutput();
+    void CloseOutput();
+
+    std::shared_ptr<MainLoop> m_mainLoop;
+    pid_t m_pid;
+    int m_pidfd;
+    int m_outputfd;  // -1 when not capturing or closed
+    Callbacks m_callbacks;
+    std::string m_partialLine;
+};
@@ -4,6 +4,7 @@
 #include <wayland-client-core.h>
 #include <wayland-client-protocol.h>
 #include <wlr-layer-shell-unstable-v1.h>
+#include <wlr-screencopy-unstable-v1.h>
 
 #include <ostream>
 
@@ -15,6 +16,7 @@
 //      - wayland version 1.20 ->
 //        - wl_shm -> version 1
 //      - zwlr_layer_shell version 4
+//      - zwlr_screencopy_manager version 3
 //      - wl_seat version 5
 //      - wl_output version 4
 //      - wl_compositor version 4
@@ -30,6 +32,12 @@ void Registry::Register(struct wl_registry *registry, uint32_t name, const char
         build_version = zwlr_layer_shell_v1_interface.version;
         this->shell = (zwlr_layer_shell_v1 *)wl_registry_bind(
             registry, name, &zwlr_layer_shell_v1_interface, wanted_version);
+    } else if (interface == std::string_view(zwlr_screencopy_manager_v1_interface.name)) {
+        // Version 1 is enough for shm captures, later versions adds damage and dmabuf
+        wanted_version = 1;
+        build_version = zwlr_screencopy_manager_v1_interface.version;
+        this->screencopy = (zwlr_screencopy_manager_v1 *)wl_registry_bind(
+            registry, name, &zwlr_screencopy_manager_v1_interface, wanted_version);
     } else if (interface == std::string_view(wl_shm_interface.name)) {
         // Defined in core wayland. There is a version 2 at time of writing..
         wanted_version = 1;
@@ -2,6 +2,7 @@
 
 #include <wayland-client-protocol.h>
 #include <wlr-layer-shell-unstable-v1.h>
+#include <wlr-screencopy-unstable-v1.h>
 
 #include <cstdint>
 #include <list>
@@ -17,10 +18,16 @@ class Registry : public IoHandler {
     static std::shared_ptr<Registry> Create(std::shared_ptr<MainLoop> mainloop,
                                             std::unique_ptr<Outputs> outputs);
     virtual ~Registry() {
+        // Outputs own surfaces, destroy while still connected
+        m_outputs = nullptr;
         wl_registry_destroy(m_registry);
         m_registry = nullptr;
         zwlr_layer_shell_v1_destroy(shell);
         shell = nullptr;
+        if (screencopy) {
+            zwlr_screencopy_manager_v1_destroy(screencopy);
+            screencopy = nullptr;
+        }
         wl_shm_destroy(m_shm);
         m_shm = nullptr;
         wl_compositor_destroy(compositor);
@@ -39,18 +46,24 @@ class Registry : public IoHandler {
     virtual bool OnRead() override;
 
     Outputs &BorrowOutputs() { return *m_outputs; }
+    wl_output *FindOutput(const std::string &name) const { return m_outputs->Find(name); }
+    wl_shm *Shm() const { return m_shm; }
 
     // These are maintained by the registry
     std::shared_ptr<Seat> seat;
     // Do not copy these!
     zwlr_layer_shell_v1 *shell;
+    zwlr_screencopy_manager_v1 *screencopy;  // Optional
     wl_compositor *compositor;
     wl_display *display;
 
    private:
     Registry(std::shared_ptr<MainLoop> mainloop, std::unique_ptr<Outputs> outputs,
              wl_display *display, wl_registry *registry)
-        : m_outputs(std::move(outputs)), m_mainloop(mainloop), m_registry(registry) {
+        : screencopy(nullptr),
+          m_outputs(std::move(outputs)),
+          m_mainloop(mainloop),
+          m_registry(registry) {
         this->display = display;
     }
 
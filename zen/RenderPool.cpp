@@ -0,0 +1,69 @@
+#include "zen/RenderPool.h"
+
+#include "spdlog/spdlog.h"
+
+std::unique_ptr<RenderPool> RenderPool::Create(int numWorkers) {
+    if (numWorkers < 2) {
+        spdlog::error("Render pool needs at least two workers");
+        return nullptr;
+    }
+    auto pool = std::unique_ptr<RenderPool>(new RenderPool());
+    for (int i = 1; i < numWorkers; i++) {
+        pool->m_threads.emplace_back(&RenderPool::Work, pool.get(), i);
+    }
+    return pool;
+}
+
+RenderPool::~RenderPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_started.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void RenderPool::Run(const std::vector<std::function<void()>>& jobs) {
+    if (jobs.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs = &jobs;
+        m_next = 0;
+        m_busy = m_threads.size();
+        m_batch++;
+    }
+    m_started.notify_all();
+    RunJobs();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished.wait(lock, [this] { return m_busy == 0; });
+    m_jobs = nullptr;
+}
+
+void RenderPool::RunJobs() {
+    for (auto i = m_next++; i < m_jobs->size(); i = m_next++) {
+        (*m_jobs)[i]();
+    }
+}
+
+void RenderPool::Work(int index) {
+    t_worker = index;
+    uint64_t batch = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_started.wait(lock, [&] { return m_isStopping || m_batch != batch; });
+        if (m_isStopping) {
+            return;
+        }
+        batch = m_batch;
+        lock.unlock();
+        RunJobs();
+        lock.lock();
+        if (--m_busy == 0) {
+            m_finished.notify_one();
+        }
+    }
+}
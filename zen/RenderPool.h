@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads that run batches of jobs in parallel, used to call render functions of
+// different outputs at the same time. Each worker is given an index that selects its own
+// Lua state. The thread running a batch takes part as worker 0 and returns when all jobs
+// are done.
+class RenderPool {
+   public:
+    static std::unique_ptr<RenderPool> Create(int numWorkers);
+    ~RenderPool();
+
+    void Run(const std::vector<std::function<void()>>& jobs);
+    int NumWorkers() const { return (int)m_threads.size() + 1; }
+    // Index of worker on the calling thread, 0 when not on a pool thread
+    static int CurrentWorker() { return t_worker; }
+
+   private:
+    RenderPool() : m_jobs(nullptr), m_next(0), m_batch(0), m_busy(0), m_isStopping(false) {}
+    void Work(int index);
+    void RunJobs();
+
+    static inline thread_local int t_worker = 0;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_started;
+    std::condition_variable m_finished;
+    const std::vector<std::function<void()>>* m_jobs;
+    std::atomic<size_t> m_next;
+    uint64_t m_batch;
+    int m_busy;  // Pool threads still in current batch
+    bool m_isStopping;
+};
@@ -0,0 +1,159 @@
+#include "zen/Screencopy.h"
+
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "zen/Registry.h"
+
+// State of a single capture, owned by the listener until ready or failed
+struct Capture {
+    Capture(zwlr_screencopy_frame_v1* frame_, wl_shm* shm_, FrameProducer::OnFrame onFrame_)
+        : frame(frame_),
+          shm(shm_),
+          buffer(nullptr),
+          address(MAP_FAILED),
+          size(0),
+          format(0),
+          cx(0),
+          cy(0),
+          stride(0),
+          flags(0),
+          onFrame(std::move(onFrame_)) {}
+    ~Capture() {
+        if (buffer) wl_buffer_destroy(buffer);
+        if (address != MAP_FAILED) munmap(address, size);
+        zwlr_screencopy_frame_v1_destroy(frame);
+    }
+
+    zwlr_screencopy_frame_v1* frame;
+    wl_shm* shm;
+    wl_buffer* buffer;
+    void* address;
+    size_t size;
+    uint32_t format;
+    int cx;
+    int cy;
+    int stride;
+    uint32_t flags;
+    FrameProducer::OnFrame onFrame;
+};
+
+static void Fail(Capture* capture) {
+    capture->onFrame(Frame{});
+    delete capture;
+}
+
+static wl_buffer* CreateBuffer(Capture& capture) {
+    int fd = memfd_create("zenway-screencopy", MFD_CLOEXEC);
+    if (fd == -1) {
+        spdlog::error("Failed to create screencopy memory: {}", strerror(errno));
+        return nullptr;
+    }
+    capture.size = (size_t)capture.stride * capture.cy;
+    if (ftruncate(fd, capture.size) == -1) {
+        spdlog::error("Failed to size screencopy memory: {}", strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    capture.address = mmap(nullptr, capture.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (capture.address == MAP_FAILED) {
+        spdlog::error("Failed to map screencopy memory: {}", strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    auto pool = wl_shm_create_pool(capture.shm, fd, capture.size);
+    auto buffer = wl_shm_pool_create_buffer(pool, 0, capture.cx, capture.cy, capture.stride,
+                                            capture.format);
+    // Buffer keeps the memory alive
+    wl_shm_pool_destroy(pool);
+    close(fd);
+    return buffer;
+}
+
+static void on_buffer(void* data, zwlr_screencopy_frame_v1* frame, uint32_t format,
+                      uint32_t width, uint32_t height, uint32_t stride) {
+    auto capture = (Capture*)data;
+    if (format != WL_SHM_FORMAT_ARGB8888 && format != WL_SHM_FORMAT_XRGB8888) {
+        spdlog::error("Unsupported screencopy format: {}", format);
+        // Nothing more will be sent for this frame
+        Fail(capture);
+        return;
+    }
+    capture->format = format;
+    capture->cx = width;
+    capture->cy = height;
+    capture->stride = stride;
+    capture->buffer = CreateBuffer(*capture);
+    if (!capture->buffer) {
+        Fail(capture);
+        return;
+    }
+    zwlr_screencopy_frame_v1_copy(frame, capture->buffer);
+}
+
+static void on_flags(void* data, zwlr_screencopy_frame_v1*, uint32_t flags) {
+    ((Capture*)data)->flags = flags;
+}
+
+static void on_ready(void* data, zwlr_screencopy_frame_v1*, uint32_t, uint32_t, uint32_t) {
+    auto capture = std::unique_ptr<Capture>((Capture*)data);
+    auto pixels = (const uint8_t*)capture->address;
+    ptrdiff_t stride = capture->stride;
+    if (capture->flags & ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT) {
+        pixels += (capture->cy - 1) * stride;
+        stride = -stride;
+    }
+    capture->onFrame(Frame{.pixels = pixels,
+                           .cx = capture->cx,
+                           .cy = capture->cy,
+                           .stride = stride,
+                           .hasAlpha = capture->format == WL_SHM_FORMAT_ARGB8888});
+}
+
+static void on_failed(void* data, zwlr_screencopy_frame_v1*) {
+    spdlog::warn("Screencopy failed");
+    Fail((Capture*)data);
+}
+
+static void on_damage(void*, zwlr_screencopy_frame_v1*, uint32_t, uint32_t, uint32_t, uint32_t) {
+}
+
+static void on_linux_dmabuf(void*, zwlr_screencopy_frame_v1*, uint32_t, uint32_t, uint32_t) {}
+
+static void on_buffer_done(void*, zwlr_screencopy_frame_v1*) {}
+
+static const zwlr_screencopy_frame_v1_listener listener = {
+    .buffer = on_buffer,
+    .flags = on_flags,
+    .ready = on_ready,
+    .failed = on_failed,
+    .damage = on_damage,
+    .linux_dmabuf = on_linux_dmabuf,
+    .buffer_done = on_buffer_done,
+};
+
+std::shared_ptr<Screencopy> Screencopy::Create(const Registry& registry) {
+    if (!registry.screencopy) {
+        spdlog::warn("Compositor does not support screencopy, no thumbnails");
+        return nullptr;
+    }
+    return std::shared_ptr<Screencopy>(new Screencopy(registry));
+}
+
+bool Screencopy::Capture(const std::string& outputName, OnFrame onFrame) {
+    auto output = m_registry.FindOutput(outputName);
+    if (!output) {
+        spdlog::error("No output named {} to capture", outputName);
+        return false;
+    }
+    auto frame = zwlr_screencopy_manager_v1_capture_output(m_registry.screencopy, 0, output);
+    // Version 1 is bound, buffer is sent directly and copy is requested from that event.
+    // The rest is handled when the wayland connection is read in main loop.
+    zwlr_screencopy_frame_v1_add_listener(
+        frame, &listener, new ::Capture(frame, m_registry.Shm(), std::move(onFrame)));
+    wl_display_flush(m_registry.display);
+    return true;
+}
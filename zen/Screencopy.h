@@ -0,0 +1,25 @@
+#pragma once
+
+#include <wayland-client-protocol.h>
+#include <wlr-screencopy-unstable-v1.h>
+
+#include <memory>
+
+#include "zen/ThumbnailCache.h"
+
+class Registry;
+
+// Captures outputs into shared memory using wlr-screencopy
+class Screencopy : public FrameProducer {
+   public:
+    // Returns null if compositor does not support screencopy
+    static std::shared_ptr<Screencopy> Create(const Registry& registry);
+    virtual ~Screencopy() {}
+
+    bool Capture(const std::string& outputName, OnFrame onFrame) override;
+
+   private:
+    Screencopy(const Registry& registry) : m_registry(registry) {}
+
+    const Registry& m_registry;
+};
@@ -1,9 +1,28 @@
 
 #include "zen/ScriptContext.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <tuple>
+
 #include "sol/sol.hpp"
 #include "spdlog/spdlog.h"
 #include "util.h"
+#include "zen/BytecodeCache.h"
+#include "zen/FileCache.h"
+#include "zen/LayoutCache.h"
+#include "zen/LazySources.h"
+#include "zen/LuaAllocator.h"
+#include "zen/LuaWatchdog.h"
+#include "zen/Metrics.h"
+#include "zen/Process.h"
+#include "zen/RenderPool.h"
+#include "zen/Template.h"
+#ifdef ZEN_LUAJIT
+#include "zen/LuaFfi.h"
+#endif
 
 int GetIntProperty(const sol::table& t, const char* name, int missing) {
     const sol::optional<int> o = t[name];
@@ -41,18 +60,89 @@ std::string TagFromTable(const sol::table& t) {
     return optionalTag ? *optionalTag : "";
 }
 
+static TextBounds MakeTextBounds(int maxWidth, int maxHeight,
+                                 std::optional<std::string_view> ellipsize) {
+    auto bounds =
+        TextBounds{.maxWidth = maxWidth, .maxHeight = maxHeight, .ellipsize = Ellipsize::None};
+    if (!ellipsize) {
+        // Ellipsize at end by default when bounded
+        if (bounds.maxWidth > 0 || bounds.maxHeight > 0) {
+            bounds.ellipsize = Ellipsize::End;
+        }
+        return bounds;
+    }
+    if (*ellipsize == "end") {
+        bounds.ellipsize = Ellipsize::End;
+    } else if (*ellipsize == "start") {
+        bounds.ellipsize = Ellipsize::Start;
+    } else if (*ellipsize == "middle") {
+        bounds.ellipsize = Ellipsize::Middle;
+    } else if (*ellipsize != "none") {
+        spdlog::error("Invalid ellipsize: {}", *ellipsize);
+    }
+    return bounds;
+}
+
+static TextBounds TextBoundsFromTable(const sol::table& t) {
+    const sol::optional<std::string_view> ellipsize = t["ellipsize"];
+    return MakeTextBounds(GetIntProperty(t, "max_width", 0), GetIntProperty(t, "max_height", 0),
+                          ellipsize ? std::optional(*ellipsize) : std::nullopt);
+}
+
+static std::unique_ptr<Markup> MarkupFromTable(const sol::table& t) {
+    const sol::optional<std::string> optionalMarkup = t["markup"];
+    auto markup = std::make_unique<Markup>(optionalMarkup ? *optionalMarkup : "");
+    markup->bounds = TextBoundsFromTable(t);
+    return markup;
+}
+
+// Box properties parsed once by zen.style, opaque to Lua
+struct BoxStyle {
+    int radius;
+    Border border;
+    RGBA color;
+    Padding padding;
+};
+
+static BoxStyle BoxStyleFromTable(const sol::table& t) {
+    return BoxStyle{.radius = GetIntProperty(t, "radius", 0),
+                    .border = BorderFromProperty(t, "border"),
+                    .color = RGBAFromProperty(t, "color"),
+                    .padding = PaddingFromProperty(t, "padding")};
+}
+
+// Properties of a style are not looked up in the box table
 static std::unique_ptr<MarkupBox> MarkupBoxFromTable(const sol::table& t) {
     const sol::optional<std::string> optionalMarkup = t["markup"];
     const std::string markup = optionalMarkup ? *optionalMarkup : "";
     auto box = std::make_unique<MarkupBox>(markup);
-    box->radius = GetIntProperty(t, "radius", 0);
-    box->border = BorderFromProperty(t, "border");
-    box->color = RGBAFromProperty(t, "color");
-    box->padding = PaddingFromProperty(t, "padding");
+    const sol::object styleObject = t["style"];
+    const auto style = styleObject.is<BoxStyle>() ? styleObject.as<const BoxStyle&>()
+                                                  : BoxStyleFromTable(t);
+    box->radius = style.radius;
+    box->border = style.border;
+    box->color = style.color;
+    box->padding = style.padding;
+    box->bounds = TextBoundsFromTable(t);
     box->tag = TagFromTable(t);
     return box;
 }
 
+static std::unique_ptr<Thumbnail> ThumbnailFromTable(const sol::table& t) {
+    const sol::optional<std::string> output = t["output"];
+    const sol::optional<std::string> workspace = t["workspace"];
+    if (!output || !workspace) {
+        spdlog::error("Thumbnail requires output and workspace");
+        return nullptr;
+    }
+    auto thumbnail = std::make_unique<Thumbnail>(*output, *workspace);
+    thumbnail->width = GetIntProperty(t, "width", 0);
+    thumbnail->height = GetIntProperty(t, "height", 0);
+    thumbnail->radius = GetIntProperty(t, "radius", 0);
+    thumbnail->tag = TagFromTable(t);
+    return thumbnail;
+}
+
 static std::unique_ptr<Renderable> FromObject(const sol::object& o);
 static void FromChildTable(const sol::table childTable,
                            std::vector<std::unique_ptr<Renderable>>& children) {
@@ -99,9 +189,602 @@ static std::unique_ptr<Renderable> FromObject(const sol::object& o) {
     if (*type == "box") {
         return MarkupBoxFromTable(t);
     }
+    if (*type == "markup") {
+        return MarkupFromTable(t);
+    }
+    if (*type == "thumbnail") {
+        return ThumbnailFromTable(t);
+    }
+    return nullptr;
+}
+
+// Render results are converted in one pass over each table with lua_next. Keys, and strings
+// of enumerated values, are interned once per Lua state. Short Lua strings are unique so
+// keys are then found by address instead of by hashing and comparing strings.
+static constexpr const char* RENDER_STRINGS[] = {
+    "type", "markup", "color", "radius", "border", "padding", "tag",
+    "style", "items", "direction", "output", "workspace", "width", "height",
+    "left", "right", "top", "bottom", "max_width", "max_height", "ellipsize",
+    "box", "flex", "thumbnail", "row", "column"};
+// In the order of the strings
+enum class RenderKey : uint8_t {
+    Type, Markup, Color, Radius, Border, Padding, Tag,
+    Style, Items, Direction, Output, Workspace, Width, Height,
+    Left, Right, Top, Bottom, MaxWidth, MaxHeight, Ellipsize,
+    Box, Flex, Thumbnail, Row, Column,
+    Unknown
+};
+static_assert((size_t)RenderKey::Unknown == std::size(RENDER_STRINGS));
+
+// Stored in the registry as userdata without finalizer, the strings are anchored beside it
+struct RenderKeys {
+    std::array<std::pair<const char*, RenderKey>, std::size(RENDER_STRINGS)> sorted;
+
+    RenderKey Find(const char* s) const {
+        auto it = std::lower_bound(sorted.begin(), sorted.end(), s, [](const auto& key, auto s) {
+            return std::less<const char*>()(key.first, s);
+        });
+        return it != sorted.end() && it->first == s ? it->second : RenderKey::Unknown;
+    }
+    RenderKey At(lua_State* L, int index) const {
+        return lua_type(L, index) == LUA_TSTRING ? Find(lua_tostring(L, index))
+                                                 : RenderKey::Unknown;
+    }
+};
+
+static const RenderKeys& InternRenderKeys(lua_State* L) {
+    lua_getfield(L, LUA_REGISTRYINDEX, "zen.render_keys");
+    auto keys = static_cast<RenderKeys*>(lua_touserdata(L, -1));
+    lua_pop(L, 1);
+    if (keys) {
+        return *keys;
+    }
+    keys = new (lua_newuserdata(L, sizeof(RenderKeys))) RenderKeys();
+    lua_createtable(L, (int)std::size(RENDER_STRINGS), 0);
+    for (size_t i = 0; i < std::size(RENDER_STRINGS); i++) {
+        lua_pushstring(L, RENDER_STRINGS[i]);
+        keys->sorted[i] = {lua_tostring(L, -1), (RenderKey)i};
+        lua_rawseti(L, -2, (int)i + 1);
+    }
+    lua_setfield(L, LUA_REGISTRYINDEX, "zen.render_strings");
+    lua_setfield(L, LUA_REGISTRYINDEX, "zen.render_keys");
+    std::sort(keys->sorted.begin(), keys->sorted.end(), [](const auto& a, const auto& b) {
+        return std::less<const char*>()(a.first, b.first);
+    });
+    return *keys;
+}
+
+static std::optional<std::string_view> StringAt(lua_State* L, int index) {
+    if (lua_type(L, index) != LUA_TSTRING) {
+        return std::nullopt;
+    }
+    size_t size;
+    const auto data = lua_tolstring(L, index, &size);
+    return std::string_view(data, size);
+}
+
+// Same as reading an int through sol2, fractions are rounded unless sol2 is built to check
+// precision, then they are missing like in debug builds
+static int IntAt(lua_State* L, int index) {
+    if (lua_type(L, index) != LUA_TNUMBER) {
+        return 0;
+    }
+    if (lua_isinteger(L, index)) {
+        return (int)lua_tointeger(L, index);
+    }
+#if SOL_IS_ON(SOL_NUMBER_PRECISION_CHECKS) && SOL_LUA_VERSION_I_ >= 503
+    return 0;
+#else
+    return (int)std::llround(lua_tonumber(L, index));
+#endif
+}
+
+static RGBA RGBAAt(lua_State* L, int index) {
+    const auto color = StringAt(L, index);
+    return color ? RGBA::FromString(std::string(*color)) : RGBA{};
+}
+
+static Border BorderAt(lua_State* L, int index, const RenderKeys& keys) {
+    auto border = Border{};
+    if (lua_type(L, index) != LUA_TTABLE) {
+        return border;
+    }
+    index = lua_absindex(L, index);
+    lua_pushnil(L);
+    while (lua_next(L, index)) {
+        switch (keys.At(L, -2)) {
+            case RenderKey::Color:
+                border.color = RGBAAt(L, -1);
+                break;
+            case RenderKey::Width:
+                border.width = IntAt(L, -1);
+                break;
+            default:
+                break;
+        }
+        lua_pop(L, 1);
+    }
+    return border;
+}
+
+static Padding PaddingAt(lua_State* L, int index, const RenderKeys& keys) {
+    auto padding = Padding{};
+    if (lua_type(L, index) != LUA_TTABLE) {
+        return padding;
+    }
+    index = lua_absindex(L, index);
+    lua_pushnil(L);
+    while (lua_next(L, index)) {
+        switch (keys.At(L, -2)) {
+            case RenderKey::Left:
+                padding.left = IntAt(L, -1);
+                break;
+            case RenderKey::Right:
+                padding.right = IntAt(L, -1);
+                break;
+            case RenderKey::Top:
+                padding.top = IntAt(L, -1);
+                break;
+            case RenderKey::Bottom:
+                padding.bottom = IntAt(L, -1);
+                break;
+            default:
+                break;
+        }
+        lua_pop(L, 1);
+    }
+    return padding;
+}
+
+static std::unique_ptr<Renderable> RenderableAt(lua_State* L, int index, const RenderKeys& keys);
+
+// Properties of all types of render tables, strings point into the table being converted
+struct RenderFields {
+    RenderKey type = RenderKey::Unknown;
+    RenderKey direction = RenderKey::Column;
+    std::optional<std::string_view> markup;
+    std::optional<std::string_view> tag;
+    std::optional<std::string_view> output;
+    std::optional<std::string_view> workspace;
+    std::optional<std::string_view> ellipsize;
+    const BoxStyle* style = nullptr;
+    BoxStyle box{};
+    int width = 0;
+    int height = 0;
+    int maxWidth = 0;
+    int maxHeight = 0;
+    std::vector<std::unique_ptr<Renderable>> items;
+};
+
+static void ReadRenderField(lua_State* L, RenderKey key, const RenderKeys& keys,
+                            RenderFields& fields) {
+    switch (key) {
+        case RenderKey::Type:
+            fields.type = keys.At(L, -1);
+            break;
+        case RenderKey::Markup:
+            fields.markup = StringAt(L, -1);
+            break;
+        case RenderKey::Color:
+            fields.box.color = RGBAAt(L, -1);
+            break;
+        case RenderKey::Radius:
+            fields.box.radius = IntAt(L, -1);
+            break;
+        case RenderKey::Border:
+            fields.box.border = BorderAt(L, -1, keys);
+            break;
+        case RenderKey::Padding:
+            fields.box.padding = PaddingAt(L, -1, keys);
+            break;
+        case RenderKey::Tag:
+            fields.tag = StringAt(L, -1);
+            break;
+        case RenderKey::Style:
+            if (sol::stack::check<BoxStyle>(L, -1)) {
+                fields.style = &sol::stack::get<BoxStyle&>(L, -1);
+            }
+            break;
+        case RenderKey::Items:
+            if (lua_type(L, -1) == LUA_TTABLE) {
+                const auto items = lua_gettop(L);
+                const auto size = (int)lua_rawlen(L, items);
+                for (int i = 1; i <= size; i++) {
+                    lua_rawgeti(L, items, i);
+                    if (auto item = RenderableAt(L, -1, keys)) {
+                        fields.items.push_back(std::move(item));
+                    }
+                    lua_pop(L, 1);
+                }
+            }
+            break;
+        case RenderKey::Direction:
+            // Neither row nor column is invalid
+            if (lua_type(L, -1) == LUA_TSTRING) {
+                fields.direction = keys.At(L, -1);
+            }
+            break;
+        case RenderKey::Output:
+            fields.output = StringAt(L, -1);
+            break;
+        case RenderKey::Workspace:
+            fields.workspace = StringAt(L, -1);
+            break;
+        case RenderKey::Width:
+            fields.width = IntAt(L, -1);
+            break;
+        case RenderKey::Height:
+            fields.height = IntAt(L, -1);
+            break;
+        case RenderKey::MaxWidth:
+            fields.maxWidth = IntAt(L, -1);
+            break;
+        case RenderKey::MaxHeight:
+            fields.maxHeight = IntAt(L, -1);
+            break;
+        case RenderKey::Ellipsize:
+            fields.ellipsize = StringAt(L, -1);
+            break;
+        default:
+            break;
+    }
+}
+
+static std::unique_ptr<Renderable> RenderableAt(lua_State* L, int index, const RenderKeys& keys) {
+    if (lua_type(L, index) == LUA_TSTRING) {
+        return std::make_unique<Markup>(std::string(*StringAt(L, index)));
+    }
+    if (lua_type(L, index) != LUA_TTABLE || !lua_checkstack(L, LUA_MINSTACK)) {
+        return nullptr;
+    }
+    // Properties might be inherited through __index, only seen when looked up
+    if (lua_getmetatable(L, index)) {
+        lua_pop(L, 1);
+        return FromObject(sol::object(L, index));
+    }
+    index = lua_absindex(L, index);
+    RenderFields fields;
+    lua_pushnil(L);
+    while (lua_next(L, index)) {
+        ReadRenderField(L, keys.At(L, -2), keys, fields);
+        lua_pop(L, 1);
+    }
+    const auto tag = std::string(fields.tag.value_or(""));
+    switch (fields.type) {
+        case RenderKey::Box: {
+            auto box = std::make_unique<MarkupBox>(std::string(fields.markup.value_or("")));
+            const auto& style = fields.style ? *fields.style : fields.box;
+            box->radius = style.radius;
+            box->border = style.border;
+            box->color = style.color;
+            box->padding = style.padding;
+            box->bounds = MakeTextBounds(fields.maxWidth, fields.maxHeight, fields.ellipsize);
+            box->tag = tag;
+            return box;
+        }
+        case RenderKey::Markup: {
+            auto markup = std::make_unique<Markup>(std::string(fields.markup.value_or("")));
+            markup->bounds = MakeTextBounds(fields.maxWidth, fields.maxHeight, fields.ellipsize);
+            return markup;
+        }
+        case RenderKey::Flex: {
+            if (fields.direction != RenderKey::Column && fields.direction != RenderKey::Row) {
+                return nullptr;
+            }
+            auto flex = std::make_unique<FlexContainer>();
+            flex->isColumn = fields.direction == RenderKey::Column;
+            flex->padding = fields.box.padding;
+            flex->children = std::move(fields.items);
+            flex->tag = tag;
+            return flex;
+        }
+        case RenderKey::Thumbnail: {
+            if (!fields.output || !fields.workspace) {
+                spdlog::error("Thumbnail requires output and workspace");
+                return nullptr;
+            }
+            auto thumbnail = std::make_unique<Thumbnail>(std::string(*fields.output),
+                                                         std::string(*fields.workspace));
+            thumbnail->width = fields.width;
+            thumbnail->height = fields.height;
+            thumbnail->radius = fields.box.radius;
+            thumbnail->tag = tag;
+            return thumbnail;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+std::unique_ptr<Renderable> RenderableFromLua(lua_State* L, int index) {
+    return RenderableAt(L, index, InternRenderKeys(L));
+}
+
+std::unique_ptr<Renderable> RenderableFromLuaLookups(lua_State* L, int index) {
+    return FromObject(sol::object(L, index));
+}
+
+// Templates are render tables compiled once at load and evaluated natively when sources
+// change. Strings and expressions from zen.bind, zen.format, zen.levels and zen.map are
+// allowed where markup or color is expected.
+using Template = std::function<std::unique_ptr<Renderable>(const BoundValues& values)>;
+
+static const char* TEMPLATE_PRELUDE = R"(
+local function expression(kind, t)
+    t._zen = kind
+    return t
+end
+function zen.bind(path) return expression("bind", { path = path }) end
+function zen.format(format, ...)
+    return expression("format", { format = format, args = { ... } })
+end
+function zen.levels(input, levels, otherwise)
+    return expression("levels", { input = input, levels = levels, otherwise = otherwise })
+end
+function zen.map(input, cases, otherwise)
+    return expression("map", { input = input, cases = cases, otherwise = otherwise })
+end
+)";
+
+static bool IsExpression(const sol::object& o) {
+    return o.get_type() == sol::type::table && o.as<sol::table>()["_zen"].valid();
+}
+
+static Expression CompileExpression(const sol::object& o);
+
+// Nil compiles to nullptr without error
+static Expression CompileOptionalExpression(const sol::object& o) {
+    return o.get_type() == sol::type::lua_nil ? nullptr : CompileExpression(o);
+}
+
+static Expression CompileLevels(const sol::table& t) {
+    auto input = CompileExpression(t["input"]);
+    const sol::optional<sol::table> levelsTable = t["levels"];
+    if (!input || !levelsTable) {
+        return nullptr;
+    }
+    std::vector<std::pair<double, Expression>> levels;
+    for (size_t i = 0; i < levelsTable->size(); i++) {
+        const sol::optional<sol::table> level = (*levelsTable)[i + 1];
+        const sol::optional<double> threshold = level ? (*level)[1] : sol::optional<double>();
+        auto value = level ? CompileExpression((*level)[2]) : nullptr;
+        if (!threshold || !value) {
+            spdlog::error("Template levels are {{threshold, value}} pairs");
+            return nullptr;
+        }
+        levels.emplace_back(*threshold, std::move(value));
+    }
+    return Expressions::Levels(std::move(input), std::move(levels),
+                               CompileOptionalExpression(t["otherwise"]));
+}
+
+static Expression CompileMap(const sol::table& t) {
+    auto input = CompileExpression(t["input"]);
+    const sol::optional<sol::table> casesTable = t["cases"];
+    if (!input || !casesTable) {
+        return nullptr;
+    }
+    std::map<std::string, Expression> cases;
+    bool isValid = true;
+    casesTable->for_each([&cases, &isValid](const sol::object& key, const sol::object& value) {
+        // Keys are matched as strings, true and false included
+        auto expression = CompileExpression(value);
+        isValid = isValid && expression;
+        cases[ToString(key.is<bool>() ? BoundValue(key.as<bool>())
+                                       : BoundValue(key.as<std::string>()))] = expression;
+    });
+    if (!isValid) {
+        return nullptr;
+    }
+    return Expressions::Map(std::move(input), std::move(cases),
+                            CompileOptionalExpression(t["otherwise"]));
+}
+
+static Expression CompileExpression(const sol::object& o) {
+    switch (o.get_type()) {
+        case sol::type::string:
+            return Expressions::Literal(o.as<std::string>());
+        case sol::type::number:
+            return Expressions::Literal(o.as<double>());
+        case sol::type::boolean:
+            return Expressions::Literal(o.as<bool>());
+        case sol::type::table:
+            break;
+        default:
+            spdlog::error("Invalid template expression");
+            return nullptr;
+    }
+    const auto t = o.as<sol::table>();
+    const auto kind = t.get_or<std::string>("_zen", "");
+    if (kind == "bind") {
+        return Expressions::Bind(t.get_or<std::string>("path", ""));
+    }
+    if (kind == "format") {
+        std::vector<Expression> args;
+        const sol::table argsTable = t["args"];
+        for (size_t i = 0; i < argsTable.size(); i++) {
+            auto arg = CompileExpression(argsTable[i + 1]);
+            if (!arg) {
+                return nullptr;
+            }
+            args.push_back(std::move(arg));
+        }
+        return Expressions::Format(t.get_or<std::string>("format", ""), std::move(args));
+    }
+    if (kind == "levels") {
+        return CompileLevels(t);
+    }
+    if (kind == "map") {
+        return CompileMap(t);
+    }
+    spdlog::error("Invalid template expression");
     return nullptr;
 }
 
+static Template CompileTemplate(const sol::object& o);
+
+static Template CompileFlexTemplate(const sol::table& t) {
+    // Static properties are parsed the same way as render tables
+    auto prototype = std::shared_ptr<FlexContainer>(new FlexContainer());
+    const sol::optional<std::string> direction = t["direction"];
+    prototype->isColumn = direction ? *direction == "column" : true;
+    if (!prototype->isColumn && *direction != "row") {
+        spdlog::error("Invalid template direction: {}", *direction);
+        return nullptr;
+    }
+    prototype->padding = PaddingFromProperty(t, "padding");
+    prototype->tag = TagFromTable(t);
+    std::vector<Template> children;
+    const sol::optional<sol::table> items = t["items"];
+    for (size_t i = 0; items && i < items->size(); i++) {
+        auto child = CompileTemplate((*items)[i + 1]);
+        if (!child) {
+            return nullptr;
+        }
+        children.push_back(std::move(child));
+    }
+    return [prototype, children](const BoundValues& values) -> std::unique_ptr<Renderable> {
+        auto flex = std::make_unique<FlexContainer>();
+        flex->isColumn = prototype->isColumn;
+        flex->padding = prototype->padding;
+        flex->tag = prototype->tag;
+        for (const auto& child : children) {
+            auto renderable = child(values);
+            if (renderable) {
+                flex->children.push_back(std::move(renderable));
+            }
+        }
+        return flex;
+    };
+}
+
+static Template CompileTemplate(const sol::object& o) {
+    if (o.get_type() != sol::type::table || IsExpression(o)) {
+        auto markup = CompileExpression(o);
+        if (!markup) {
+            return nullptr;
+        }
+        return [markup](const BoundValues& values) -> std::unique_ptr<Renderable> {
+            return std::make_unique<Markup>(ToString(markup(values)));
+        };
+    }
+    const auto t = o.as<sol::table>();
+    const auto type = t.get_or<std::string>("type", "");
+    if (type == "markup") {
+        auto markup = CompileExpression(t["markup"]);
+        if (!markup) {
+            return nullptr;
+        }
+        const auto bounds = TextBoundsFromTable(t);
+        return [markup, bounds](const BoundValues& values) -> std::unique_ptr<Renderable> {
+            auto renderable = std::make_unique<Markup>(ToString(markup(values)));
+            renderable->bounds = bounds;
+            return renderable;
+        };
+    }
+    if (type == "box") {
+        auto markup = CompileExpression(t["markup"]);
+        auto color = CompileOptionalExpression(t["color"]);
+        if (!markup || (!color && t["color"].valid())) {
+            return nullptr;
+        }
+        // Bound properties are ignored when parsing the static ones
+        auto prototype = std::shared_ptr<MarkupBox>(MarkupBoxFromTable(t));
+        return [markup, color, prototype](const BoundValues& values)
+                   -> std::unique_ptr<Renderable> {
+            auto box = std::make_unique<MarkupBox>(ToString(markup(values)));
+            box->color = color ? RGBA::FromString(ToString(color(values))) : prototype->color;
+            box->border = prototype->border;
+            box->radius = prototype->radius;
+            box->padding = prototype->padding;
+            box->bounds = prototype->bounds;
+            box->tag = prototype->tag;
+            return box;
+        };
+    }
+    if (type == "flex") {
+        return CompileFlexTemplate(t);
+    }
+    spdlog::error("Invalid template type: {}", type);
+    return nullptr;
+}
+
+// Bytes allocated by Lua so far. LuaJIT does not support custom allocators on 64 bit, the
+// heap size is used instead which is off when the collector runs.
+static int64_t AllocatedBytes(lua_State* L) {
+#ifdef ZEN_LUAJIT
+    return (int64_t)lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+#else
+    void* allocator = nullptr;
+    lua_getallocf(L, &allocator);
+    return static_cast<LuaAllocator*>(allocator)->Allocated();
+#endif
+}
+
+#ifdef ZEN_LUAJIT
+// LuaJIT does not run hooks in compiled code, callbacks with a budget and the functions they
+// define are interpreted for the watchdog to abort them. Functions they call are compiled.
+static void InterpretBudgeted(const sol::protected_function& fn,
+                              std::chrono::microseconds budget) {
+    if (budget.count() == 0) {
+        return;
+    }
+    sol::state_view lua(fn.lua_state());
+    sol::protected_function off = lua["jit"]["off"];
+    off(fn, true);
+}
+#else
+static void InterpretBudgeted(const sol::protected_function&, std::chrono::microseconds) {}
+#endif
+
+// Records time and allocations of a call into Lua when going out of scope. The call is
+// aborted by the watchdog when running over budget.
+class CallProbe {
+   public:
+    CallProbe(CallStats& stats, lua_State* L, std::chrono::microseconds budget)
+        : m_stats(stats),
+          m_outer(s_current),
+          m_lua(L),
+          m_start(Clock::now()),
+          m_allocated(AllocatedBytes(L)),
+          m_watch(LuaWatchdog::Shared().Begin(L, budget)),
+          m_isOverrun(false) {
+        s_current = &m_stats;
+    }
+    ~CallProbe() {
+        EndWatch();
+        ScriptStats::Shared().Record(m_stats, Clock::now() - m_start,
+                                     AllocatedBytes(m_lua) - m_allocated);
+        s_current = m_outer;
+    }
+    // True if the call has returned because it was aborted
+    bool IsOverrun() {
+        EndWatch();
+        return m_isOverrun;
+    }
+    // Stats of the innermost callback being called, nullptr when not in a callback
+    static const CallStats* Current() { return s_current; }
+
+   private:
+    using Clock = std::chrono::steady_clock;
+    void EndWatch() {
+        if (m_watch != 0 && LuaWatchdog::Shared().End(m_watch)) {
+            spdlog::warn("{} aborted, running over callback budget", m_stats.name);
+            m_isOverrun = true;
+        }
+        m_watch = 0;
+    }
+
+    static inline thread_local const CallStats* s_current = nullptr;
+    CallStats& m_stats;
+    const CallStats* m_outer;
+    lua_State* m_lua;
+    Clock::time_point m_start;
+    int64_t m_allocated;
+    uint64_t m_watch;
+    bool m_isOverrun;
+};
+
 static std::set<std::string> ParseSources(const sol::table& widgetTable) {
     std::set<std::string> sources;
     const sol::optional<sol::table> table = widgetTable["sources"];
@@ -115,28 +798,100 @@ static std::set<std::string> ParseSources(const sol::table& widgetTable) {
     return sources;
 }
 
-static void ParseWidgetConfig(const sol::table& table, std::vector<WidgetConfig>& widgets) {
+// Render functions aborted by the watchdog are skipped for a while, twice as long each time
+// they are aborted in a row. The widget is drawn empty until rendered again.
+class RenderBackoff {
+   public:
+    RenderBackoff() : m_failures(0), m_isDrawnEmpty(false) {}
+    bool IsSkipped() const { return Clock::now() < m_until; }
+    bool IsDrawnEmpty() const { return m_isDrawnEmpty; }
+    // Returns how long the render function is skipped
+    std::chrono::seconds Failed(const std::string& name) {
+        const auto skip = std::chrono::seconds(1 << std::min(m_failures, MAX_DOUBLINGS));
+        spdlog::warn("Skipping {} for {}s", name, skip.count());
+        m_until = Clock::now() + skip;
+        m_failures++;
+        m_isDrawnEmpty = true;
+        return skip;
+    }
+    void Succeeded() {
+        m_failures = 0;
+        m_isDrawnEmpty = false;
+    }
+
+   private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int MAX_DOUBLINGS = 6;
+    int m_failures;
+    bool m_isDrawnEmpty;
+    Clock::time_point m_until;
+};
+
+// Callbacks are profiled under name, or name from widget table when set. Widgets are
+// rendered by on_render or by a template evaluated from bound values. Timers are null in
+// render workers.
+static void ParseWidgetConfig(const sol::table& table, std::vector<WidgetConfig>& widgets,
+                              const std::string& name, std::shared_ptr<const BoundValues> values,
+                              std::chrono::microseconds callbackBudget,
+                              std::shared_ptr<Timers> timers) {
     WidgetConfig widget;
     widget.sources = ParseSources(table);
+    const auto statsName = table.get_or<std::string>("name", name);
     sol::optional<sol::protected_function> maybeRenderFunction = table["on_render"];
-    if (!maybeRenderFunction) {
+    const sol::object templateObject = table["template"];
+    if (maybeRenderFunction) {
+        auto renderFunction = *maybeRenderFunction;
+        InterpretBudgeted(renderFunction, callbackBudget);
+        auto& renderStats = ScriptStats::Shared().Register(statsName + ".render");
+        auto backoff = std::make_shared<RenderBackoff>();
+        widget.render = [renderFunction, &renderStats, callbackBudget, backoff,
+                         timers](auto outputName) {
+            if (backoff->IsSkipped()) {
+                return std::make_unique<Renderable>();
+            }
+            CallProbe probe(renderStats, renderFunction.lua_state(), callbackBudget);
+            sol::optional<sol::object> result = renderFunction(outputName);
+            if (probe.IsOverrun()) {
+                const auto skip = backoff->Failed(renderStats.name);
+                // Wakes up to draw it when skipping ends, render workers are drawn again on
+                // the next draw after that
+                if (timers) {
+                    timers->Start(skip, std::chrono::milliseconds(0), false,
+                                  [] { return false; });
+                }
+                return std::make_unique<Renderable>();
+            }
+            backoff->Succeeded();
+            if (!result) {
+                spdlog::error("Bad return from render function");
+                return std::unique_ptr<Renderable>(nullptr);
+            }
+            const auto L = renderFunction.lua_state();
+            result->push(L);
+            auto renderable = RenderableFromLua(L, -1);
+            lua_pop(L, 1);
+            return renderable;
+        };
+        widget.isBackedOff = [backoff] { return backoff->IsDrawnEmpty(); };
+    } else if (templateObject.get_type() != sol::type::lua_nil) {
+        auto compiled = CompileTemplate(templateObject);
+        if (!compiled) {
+            spdlog::error("Invalid template in {}", statsName);
+            return;
+        }
+        widget.render = [compiled, values](auto) { return compiled(*values); };
+    } else {
         // TODO: Log
         return;
     }
-    auto renderFunction = *maybeRenderFunction;
-    widget.render = [renderFunction](auto outputName) {
-        sol::optional<sol::object> result = renderFunction(outputName);
-        if (!result) {
-            spdlog::error("Bad return from render function");
-            return std::unique_ptr<Renderable>(nullptr);
-        }
-        return FromObject(*result);
-    };
     // Click handler
     sol::optional<sol::protected_function> maybeClickFunction = table["on_click"];
     if (maybeClickFunction) {
         auto clickFunction = *maybeClickFunction;
-        widget.click = [clickFunction](std::string_view tag) {
+        InterpretBudgeted(clickFunction, callbackBudget);
+        auto& clickStats = ScriptStats::Shared().Register(statsName + ".click");
+        widget.click = [clickFunction, &clickStats, callbackBudget](std::string_view tag) {
+            CallProbe probe(clickStats, clickFunction.lua_state(), callbackBudget);
             clickFunction(tag);
             return true;
         };
@@ -145,7 +900,11 @@ static void ParseWidgetConfig(const sol::table& table, std::vector<WidgetConfig>
     sol::optional<sol::protected_function> maybeWheelFunction = table["on_wheel"];
     if (maybeWheelFunction) {
         auto wheelFunction = *maybeWheelFunction;
-        widget.wheel = [wheelFunction](std::string_view tag, int value) {
+        InterpretBudgeted(wheelFunction, callbackBudget);
+        auto& wheelStats = ScriptStats::Shared().Register(statsName + ".wheel");
+        widget.wheel = [wheelFunction, &wheelStats, callbackBudget](std::string_view tag,
+                                                                    int value) {
+            CallProbe probe(wheelStats, wheelFunction.lua_state(), callbackBudget);
             wheelFunction(tag, value);
             return true;
         };
@@ -154,11 +913,26 @@ static void ParseWidgetConfig(const sol::table& table, std::vector<WidgetConfig>
     widgets.push_back(std::move(widget));
 }
 
-static PanelConfig ParsePanelConfig(const sol::table panelTable, int index) {
+// Time a callback can run before being aborted, unless configured
+static constexpr std::chrono::microseconds CALLBACK_BUDGET{500000};
+
+// Milliseconds in configuration
+static std::chrono::microseconds BudgetFromProperty(const sol::table& t, const char* name,
+                                                    std::chrono::microseconds missing) {
+    const sol::optional<double> ms = t[name];
+    return ms ? std::chrono::microseconds((int64_t)(*ms * 1000)) : missing;
+}
+
+static PanelConfig ParsePanelConfig(const sol::table panelTable, int index,
+                                    std::chrono::microseconds budget,
+                                    std::shared_ptr<const BoundValues> values,
+                                    std::chrono::microseconds callbackBudget,
+                                    std::shared_ptr<Timers> timers) {
     auto panel = PanelConfig{};
     if (!panelTable) {
         return panel;
     }
+    panel.budget = BudgetFromProperty(panelTable, "budget", budget);
     const sol::optional<std::string> anchorString = panelTable["anchor"];
     panel.index = index;
     panel.anchor = Anchor::Left;
@@ -187,10 +961,14 @@ static PanelConfig ParsePanelConfig(const sol::table panelTable, int index) {
     const sol::optional<std::string> directionString = panelTable["direction"];
     panel.isColumn = !directionString || *directionString != "row";
 
+    const auto name = index >= 0 ? fmt::format("panel{}", index) : std::string("alert");
     sol::optional<sol::protected_function> optionalCheckDisplay = panelTable["on_display"];
     if (optionalCheckDisplay) {
         auto checkDisplay = *optionalCheckDisplay;
-        panel.checkDisplay = [checkDisplay](auto outputName) {
+        InterpretBudgeted(checkDisplay, callbackBudget);
+        auto& displayStats = ScriptStats::Shared().Register(name + ".display");
+        panel.checkDisplay = [checkDisplay, &displayStats, callbackBudget](auto outputName) {
+            CallProbe probe(displayStats, checkDisplay.lua_state(), callbackBudget);
             sol::optional<bool> b = checkDisplay(outputName);
             if (b) {
                 return *b;
@@ -215,25 +993,288 @@ static PanelConfig ParsePanelConfig(const sol::table panelTable, int index) {
             // TODO: Log!
             continue;
         }
-        ParseWidgetConfig(*widgetTable, panel.widgets);
+        ParseWidgetConfig(*widgetTable, panel.widgets, fmt::format("{}.widget{}", name, i),
+                          values, callbackBudget, timers);
     }
     return panel;
 }
 
+#ifdef ZEN_LUAJIT
+// Declares the source state structs and returns a function binding a state to zen[name].
+// Metatypes make the structs read like the tables published by PUC Lua builds: strings
+// are Lua strings, arrays are 1-based with length and displays are indexed by name.
+// Iterating needs pairs and ipairs to know about the arrays.
+static const char* FFI_PRELUDE = R"(
+local declarations = ...
+local ffi = require("ffi")
+ffi.cdef(declarations)
+
+local function text(s)
+    return ffi.string(s.data, s.size)
+end
+
+local function element(self, i)
+    if type(i) == "number" and i >= 1 and i <= self.count then
+        return self.items[i - 1]
+    end
+    return nil
+end
+
+local function element_by_name(self, key)
+    if type(key) ~= "string" then
+        return element(self, key)
+    end
+    for i = 0, self.count - 1 do
+        local item = self.items[i]
+        if item._name.size == #key and text(item._name) == key then
+            return item
+        end
+    end
+    return nil
+end
+
+local function array(index)
+    return { __index = index, __len = function(self) return self.count end }
+end
+
+local function with_strings(fields)
+    return {
+        __index = function(self, key)
+            local field = fields[key]
+            if field then return text(self[field]) end
+            return nil
+        end,
+    }
+end
+
+ffi.metatype("struct zen_audio", with_strings({ port = "_port" }))
+ffi.metatype("struct zen_network", with_strings({ interface = "_interface", address = "_address" }))
+ffi.metatype("struct zen_application", with_strings({ name = "_name", appid = "_appid" }))
+ffi.metatype("struct zen_workspace", with_strings({ name = "_name" }))
+ffi.metatype("struct zen_display", with_strings({ name = "_name" }))
+ffi.metatype("struct zen_networks", array(element))
+ffi.metatype("struct zen_applications", array(element))
+ffi.metatype("struct zen_workspaces", array(element))
+ffi.metatype("struct zen_displays", array(element_by_name))
+
+local function next_element(self, i)
+    if i < self.count then return i + 1, self.items[i] end
+end
+
+local raw_pairs, raw_ipairs = pairs, ipairs
+ipairs = function(t)
+    if type(t) == "cdata" then return next_element, t, 0 end
+    return raw_ipairs(t)
+end
+pairs = function(t)
+    if type(t) ~= "cdata" then return raw_pairs(t) end
+    if not ffi.istype("struct zen_displays", t) then return next_element, t, 0 end
+    -- Displays are keyed by name
+    local i = 0
+    return function()
+        if i >= t.count then return nil end
+        local display = t.items[i]
+        i = i + 1
+        return text(display._name), display
+    end
+end
+
+return function(name, ctype, pointer)
+    zen[name] = ffi.cast(ctype .. "*", pointer)[0]
+end
+)";
+#endif
+
+class ScriptContextImpl;
+static std::unique_ptr<ScriptContextImpl> CreateImpl();
+struct TimerHandle;
+
+// Timers are not started in render workers, globals they update are not seen by render
+// functions called there
+static void WarnTimersWithWorkers() {
+    spdlog::warn("Timers only run in the first of the render_workers Lua states");
+}
+
 class ScriptContextImpl : public ScriptContext {
    public:
-    ScriptContextImpl(sol::state&& lua) : m_lua(std::move(lua)) {}
+    ScriptContextImpl(std::unique_ptr<LuaAllocator> allocator, sol::state&& lua)
+        : m_allocator(std::move(allocator)),
+          m_lua(std::move(lua)),
+          m_isLazy(false),
+          m_bound(std::make_shared<BoundValues>()),
+          m_callbacks(std::make_shared<sol::table>(m_lua.create_table())),
+          m_nextCallback(1),
+          m_cache(m_lua.create_table()),
+          m_hasTimers(false),
+          m_isWorker(false) {
+        m_lua["zen"]["spawn"] = [this](const sol::table& argv, sol::optional<sol::table> options) {
+            return Spawn(argv, options);
+        };
+        m_lua["zen"]["cache"] = [this](const std::string& key, const sol::table& deps,
+                                       const sol::protected_function& function) {
+            return Cache(key, deps, function);
+        };
+        m_lua["zen"]["fs"]["lines"] = [this](const std::string& path) { return Lines(path); };
+        m_lua["zen"]["every"] = [this](double ms, const sol::object& function,
+                                       sol::optional<sol::table> options) {
+            return StartTimer("zen.every", ms, ms, function, options);
+        };
+        m_lua["zen"]["after"] = [this](double ms, const sol::object& function,
+                                       sol::optional<sol::table> options) {
+            return StartTimer("zen.after", ms, 0, function, options);
+        };
+    }
     std::shared_ptr<Configuration> Execute(const char* path) override;
     void Publish(const std::string_view name, const Displays& displays) override;
     void Publish(const std::string_view name, const PowerState& power) override;
     void Publish(const std::string_view name, const AudioState& audio) override;
     void Publish(const std::string_view name, const KeyboardState& keyboard) override;
     void Publish(const std::string_view name, const Networks& networks) override;
+    void Publish(const std::string_view name, const Alerts& alerts) override;
+    void Publish(const std::string_view name, const std::vector<CallStats>& stats) override;
+    void Publish(const std::string_view name, const ScriptValue& value) override;
+    bool CollectGarbage(std::chrono::microseconds budget) override;
+    void Attach(std::shared_ptr<MainLoop> mainLoop, std::shared_ptr<Timers> timers) override {
+        m_mainLoop = mainLoop;
+        m_timers = timers;
+    }
+
+#ifdef ZEN_LUAJIT
+    bool InitializeFfi();
+#endif
+    // Executes configuration without starting render workers, for contexts of workers
+    void SetWorker() { m_isWorker = true; }
+    // Poll function of a source in executed configuration
+    sol::optional<sol::protected_function> PollFunction(const std::string& source) {
+        if (!m_root.valid()) {
+            return sol::nullopt;
+        }
+        const sol::object poll = m_root.traverse_get<sol::object>("sources", source, "poll");
+        if (poll.get_type() != sol::type::function) {
+            return sol::nullopt;
+        }
+        return poll.as<sol::protected_function>();
+    }
 
    private:
+    friend struct TimerHandle;
+    std::vector<std::string> LoadedFiles(const char* path);
+    // Executes configuration in a Lua state per extra render worker and makes render
+    // functions call into the state of the worker they are called on
+    bool StartWorkers(const char* path, Configuration& config);
+    template <typename State>
+    void PublishWorkers(const std::string_view name, const State& state) {
+        for (auto& worker : m_workers) {
+            worker->Publish(name, state);
+        }
+    }
+    sol::object Spawn(const sol::table& argvTable, sol::optional<sol::table> options);
+    sol::object Cache(const std::string& key, const sol::table& deps,
+                      const sol::protected_function& function);
+    sol::object Lines(const std::string& path);
+    // Timers run in the state of the main thread, workers ignore them
+    sol::object StartTimer(const char* what, double delayMs, double intervalMs,
+                           const sol::object& function, sol::optional<sol::table> options);
+    // Lua functions invoked later from io handlers are kept in a table owned by the state
+    // and referred to by id, handlers might outlive the state when configuration is
+    // reloaded. Ids are never 0, which is returned when function is not a function.
+    int KeepCallback(const sol::object& function);
+    template <typename... Args>
+    static void InvokeCallback(const std::weak_ptr<sol::table>& callbacks, int id,
+                               const char* what, Args&&... args);
+    static void DropCallbacks(const std::weak_ptr<sol::table>& callbacks,
+                              std::initializer_list<int> ids);
+    void IncreaseVersion(const std::string_view source) {
+        auto it = m_versions.find(source);
+        if (it == m_versions.end()) {
+            it = m_versions.emplace(std::string(source), 0).first;
+        }
+        it->second++;
+    }
+    void Bind(const std::string_view source, const char* field, BoundValue value) {
+        m_bound->Set(fmt::format("{}.{}", source, field), std::move(value));
+    }
+#ifdef ZEN_LUAJIT
+    // Updates state and binds it to zen[name] the first time it is published
+    template <typename Ffi, typename State>
+    void PublishFfi(std::map<std::string, std::unique_ptr<Ffi>, std::less<>>& published,
+                    const std::string_view name, const State& state);
+
+    // Declared before the Lua state to outlive it
+    std::map<std::string, std::unique_ptr<FfiPower>, std::less<>> m_ffiPower;
+    std::map<std::string, std::unique_ptr<FfiAudio>, std::less<>> m_ffiAudio;
+    std::map<std::string, std::unique_ptr<FfiNetworks>, std::less<>> m_ffiNetworks;
+    std::map<std::string, std::unique_ptr<FfiDisplays>, std::less<>> m_ffiDisplays;
+#endif
+    std::unique_ptr<LuaAllocator> m_allocator;
     sol::state m_lua;
+    // Set by lazy_sources in configuration
+    bool m_isLazy;
+    LazySources m_lazy;
+    // Source fields for templates, as <source>.<field>
+    std::shared_ptr<BoundValues> m_bound;
+    std::shared_ptr<MainLoop> m_mainLoop;
+    std::shared_ptr<Timers> m_timers;
+    // Increased on every publish of a source
+    std::map<std::string, uint64_t, std::less<>> m_versions;
+    // Versions of the dependencies each zen.cache entry was computed from
+    std::map<std::string, std::vector<uint64_t>> m_cacheVersions;
+    // Released before the Lua state
+    std::shared_ptr<sol::table> m_callbacks;
+    int m_nextCallback;
+    sol::table m_cache;
+    // Tables returned by zen.fs.lines, per path with the file they were built from
+    std::map<std::string, std::pair<std::shared_ptr<const CachedFile>, sol::table>> m_lines;
+#ifdef ZEN_LUAJIT
+    sol::protected_function m_bindFfi;
+#endif
+    // Contexts of render workers 1 and up, published the same sources
+    std::vector<std::unique_ptr<ScriptContextImpl>> m_workers;
+    // Set when zen.every or zen.after started a timer
+    bool m_hasTimers;
+    bool m_isWorker;
+    // Table returned by configuration
+    sol::table m_root;
 };
 
+#ifdef ZEN_LUAJIT
+bool ScriptContextImpl::InitializeFfi() {
+    sol::load_result prelude = m_lua.load(FFI_PRELUDE, "=ffi");
+    if (!prelude.valid()) {
+        sol::error e = prelude;
+        spdlog::error("Failed to load FFI prelude: {}", e.what());
+        return false;
+    }
+    auto declare = prelude.get<sol::protected_function>();
+    sol::protected_function_result bind = declare(FFI_DECLARATIONS);
+    if (!bind.valid()) {
+        sol::error e = bind;
+        spdlog::error("Failed to declare FFI states: {}", e.what());
+        return false;
+    }
+    m_bindFfi = bind.get<sol::protected_function>();
+    return true;
+}
+
+template <typename Ffi, typename State>
+void ScriptContextImpl::PublishFfi(
+    std::map<std::string, std::unique_ptr<Ffi>, std::less<>>& published,
+    const std::string_view name, const State& state) {
+    auto it = published.find(name);
+    if (it != published.end()) {
+        it->second->Update(state);
+        return;
+    }
+    it = published.emplace(std::string(name), std::make_unique<Ffi>()).first;
+    it->second->Update(state);
+    auto result = m_bindFfi(name, Ffi::CTYPE, (void*)&it->second->root);
+    if (!result.valid()) {
+        sol::error e = result;
+        spdlog::error("Failed to bind {}: {}", name, e.what());
+    }
+}
+#endif
+
 static DisplaysConfig ParseDisplays(sol::optional<sol::table> sourcesTable) {
     auto config = DisplaysConfig{.compositor = Compositor::Sway};
     if (!sourcesTable) {
@@ -250,6 +1291,27 @@ static DisplaysConfig ParseDisplays(sol::optional<sol::table> sourcesTable) {
     return config;
 }
 
+// Sources with a poll function, polled every interval
+static std::map<std::string, std::chrono::milliseconds> ParseLuaSources(
+    sol::optional<sol::table> sourcesTable) {
+    std::map<std::string, std::chrono::milliseconds> sources;
+    if (!sourcesTable) {
+        return sources;
+    }
+    sourcesTable->for_each([&](const sol::object& key, const sol::object& value) {
+        if (key.get_type() != sol::type::string || value.get_type() != sol::type::table) {
+            return;
+        }
+        const auto table = value.as<sol::table>();
+        if (table["poll"].get_type() != sol::type::function) {
+            return;
+        }
+        const auto interval = std::max(GetIntProperty(table, "interval", 1000), 10);
+        sources[key.as<std::string>()] = std::chrono::milliseconds(interval);
+    });
+    return sources;
+}
+
 static AudioConfig ParseAudio(sol::optional<sol::table> sourcesTable) {
     auto config = AudioConfig{.soundServer = SoundServer::PulseAudio};
     if (!sourcesTable) {
@@ -266,7 +1328,50 @@ static AudioConfig ParseAudio(sol::optional<sol::table> sourcesTable) {
     return config;
 }
 
-static std::shared_ptr<Configuration> ParseConfig(sol::optional<sol::table> root) {
+static const char* AlertKindName(AlertKind kind) {
+    switch (kind) {
+        case AlertKind::Power:
+            return "power";
+        case AlertKind::Network:
+            return "network";
+        case AlertKind::Window:
+            return "window";
+    }
+    return "";
+}
+
+static const char* AlertPriorityName(AlertPriority priority) {
+    switch (priority) {
+        case AlertPriority::Low:
+            return "low";
+        case AlertPriority::Normal:
+            return "normal";
+        case AlertPriority::High:
+            return "high";
+        case AlertPriority::Critical:
+            return "critical";
+    }
+    return "";
+}
+
+static AlertsConfig ParseAlerts(sol::optional<sol::table> alertTable) {
+    auto config = AlertsConfig{};
+    if (!alertTable) {
+        return config;
+    }
+    // Default timeout for all kinds, can be overridden per kind
+    auto timeout = GetIntProperty(*alertTable, "timeout", 0);
+    const sol::optional<sol::table> timeoutsTable = (*alertTable)["timeouts"];
+    for (auto kind : {AlertKind::Power, AlertKind::Network, AlertKind::Window}) {
+        config.timeouts[kind] =
+            timeoutsTable ? GetIntProperty(*timeoutsTable, AlertKindName(kind), timeout) : timeout;
+    }
+    return config;
+}
+
+static std::shared_ptr<Configuration> ParseConfig(sol::optional<sol::table> root,
+                                                  std::shared_ptr<const BoundValues> values,
+                                                  std::shared_ptr<Timers> timers) {
     if (!root) return nullptr;
     // "Parse" the configuration state
     sol::optional<sol::table> panelsTable = (*root)["panels"];
@@ -275,6 +1380,10 @@ static std::shared_ptr<Configuration> ParseConfig(sol::optional<sol::table> root
         return nullptr;
     }
     auto config = std::unique_ptr<Configuration>(new Configuration());
+    // Default frame budget of all panels
+    const auto budget = BudgetFromProperty(*root, "frame_budget", std::chrono::microseconds(0));
+    // Callbacks running longer are aborted, zero to never abort
+    const auto callbackBudget = BudgetFromProperty(*root, "callback_budget", CALLBACK_BUDGET);
     // Panels
     for (size_t i = 0; i < panelsTable->size(); i++) {
         sol::optional<sol::table> panelTable = (*panelsTable)[i + 1];
@@ -282,19 +1391,22 @@ static std::shared_ptr<Configuration> ParseConfig(sol::optional<sol::table> root
             spdlog::error("Expected panel table");
             continue;
         }
-        auto panel = ParsePanelConfig(*panelTable, i);
+        auto panel = ParsePanelConfig(*panelTable, i, budget, values, callbackBudget, timers);
         config->panels.push_back(panel);
     }
     // Alert panel. Reserve index -1 for alert
-    std::optional<sol::table> alertPanelTable = (*root)["alert"];
+    sol::optional<sol::table> alertPanelTable = (*root)["alert"];
+    config->alerts = ParseAlerts(alertPanelTable);
     if (alertPanelTable) {
-        config->alertPanel = ParsePanelConfig(*alertPanelTable, -1);
+        config->alertPanel =
+            ParsePanelConfig(*alertPanelTable, -1, budget, values, callbackBudget, timers);
     } else {
         config->alertPanel = PanelConfig{.widgets = {},
                                          .index = -1,
                                          .anchor = Anchor::Center,
                                          .isColumn = false,
-                                         .checkDisplay = nullptr};
+                                         .checkDisplay = nullptr,
+                                         .budget = budget};
     }
 
     // Buffers
@@ -307,107 +1419,839 @@ static std::shared_ptr<Configuration> ParseConfig(sol::optional<sol::table> root
         config->bufferWidth = GetIntProperty(*buffersTable, "width", config->bufferWidth);
         config->bufferHeight = GetIntProperty(*buffersTable, "height", config->bufferHeight);
     }
+    config->renderWorkers = std::max(root->get_or("render_workers", 1), 1);
     // Sources
     auto sources = root->get<sol::optional<sol::table>>("sources");
     config->displays = ParseDisplays(sources);
     config->audio = ParseAudio(sources);
+    config->luaSources = ParseLuaSources(sources);
     return config;
 }
 
 std::shared_ptr<Configuration> ScriptContextImpl::Execute(const char* path) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    auto& cache = BytecodeCache::Shared();
+    const auto hits = cache.Hits();
+    const auto misses = cache.Misses();
     try {
-        sol::optional<sol::table> configTable = m_lua.script_file(path);
-        return ParseConfig(configTable);
+        if (cache.Load(m_lua, path) != LUA_OK) {
+            spdlog::error("Failed to load configuration file: {}", lua_tostring(m_lua, -1));
+            lua_pop(m_lua, 1);
+            return nullptr;
+        }
+        sol::protected_function chunk(m_lua, -1);
+        lua_pop(m_lua, 1);
+        sol::protected_function_result result = chunk();
+        if (!result.valid()) {
+            sol::error e = result;
+            spdlog::error("Failed to  execute configuration file: {}", e.what());
+            return nullptr;
+        }
+        const auto elapsed = Clock::now() - start;
+        spdlog::info("Configuration executed in {} ms, {} chunks from bytecode cache, {} compiled",
+                     std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(),
+                     cache.Hits() - hits, cache.Misses() - misses);
+        sol::optional<sol::table> configTable = result;
+        if (configTable) {
+            m_isLazy = configTable->get_or("lazy_sources", false);
+            m_root = *configTable;
+        }
+        auto config = ParseConfig(configTable, m_bound, m_timers);
+        if (config) {
+            config->files = LoadedFiles(path);
+        }
+        if (config && config->renderWorkers > 1 && !m_isWorker &&
+            !StartWorkers(path, *config)) {
+            spdlog::error("Failed to start render workers, rendering on main thread");
+            m_workers.clear();
+            config->renderWorkers = 1;
+        }
+        if (m_hasTimers && !m_workers.empty()) {
+            WarnTimersWithWorkers();
+        }
+        return config;
     } catch (const sol::error& e) {
         spdlog::error("Failed to  execute configuration file: {}", e.what());
         return nullptr;
     }
 }
 
+// Widgets with a render function, alert panel last
+static std::vector<WidgetConfig*> RenderedWidgets(Configuration& config) {
+    std::vector<WidgetConfig*> widgets;
+    for (auto& panel : config.panels) {
+        for (auto& widget : panel.widgets) {
+            widgets.push_back(&widget);
+        }
+    }
+    for (auto& widget : config.alertPanel.widgets) {
+        widgets.push_back(&widget);
+    }
+    return widgets;
+}
+
+bool ScriptContextImpl::StartWorkers(const char* path, Configuration& config) {
+    auto widgets = RenderedWidgets(config);
+    std::vector<std::vector<WidgetConfig*>> workerWidgets;
+    // Keeps the configurations of workers until their render functions are taken
+    std::vector<std::shared_ptr<Configuration>> workerConfigs;
+    for (int i = 1; i < config.renderWorkers; i++) {
+        auto worker = CreateImpl();
+        if (!worker) {
+            return false;
+        }
+        worker->SetWorker();
+        auto workerConfig = worker->Execute(path);
+        if (!workerConfig) {
+            return false;
+        }
+        workerWidgets.push_back(RenderedWidgets(*workerConfig));
+        if (workerWidgets.back().size() != widgets.size()) {
+            spdlog::error("Configuration has different widgets in render worker {}", i);
+            return false;
+        }
+        workerConfigs.push_back(std::move(workerConfig));
+        m_workers.push_back(std::move(worker));
+    }
+    for (size_t i = 0; i < widgets.size(); i++) {
+        std::vector<decltype(WidgetConfig::render)> renders = {widgets[i]->render};
+        std::vector<decltype(WidgetConfig::isBackedOff)> backedOff = {widgets[i]->isBackedOff};
+        for (const auto& rendered : workerWidgets) {
+            renders.push_back(rendered[i]->render);
+            backedOff.push_back(rendered[i]->isBackedOff);
+        }
+        widgets[i]->render = [renders = std::move(renders)](const std::string& outputName) {
+            return renders.at(RenderPool::CurrentWorker())(outputName);
+        };
+        if (widgets[i]->isBackedOff) {
+            widgets[i]->isBackedOff = [backedOff = std::move(backedOff)] {
+                return std::ranges::any_of(backedOff, [](const auto& is) { return is(); });
+            };
+        }
+    }
+    spdlog::info("Render functions are called in {} Lua states", config.renderWorkers);
+    return true;
+}
+
+// Configuration file and the files of modules it required
+std::vector<std::string> ScriptContextImpl::LoadedFiles(const char* path) {
+    std::vector<std::string> files = {std::filesystem::absolute(path)};
+    sol::table package = m_lua["package"];
+    const sol::optional<std::string> searchPath = package["path"];
+    sol::optional<sol::protected_function> searchpath = package["searchpath"];
+    const sol::optional<sol::table> loaded = package["loaded"];
+    if (!searchPath || !searchpath || !loaded) {
+        return files;
+    }
+    loaded->for_each([&](const sol::object& name, const sol::object&) {
+        if (name.get_type() != sol::type::string) {
+            return;
+        }
+        // Built in modules are not found
+        sol::optional<std::string> file = (*searchpath)(name.as<std::string>(), *searchPath);
+        if (file) {
+            files.push_back(std::filesystem::absolute(*file));
+        }
+    });
+    return files;
+}
+
+// Publishing patches the tables published previously instead of replacing them, the
+// steady state should not create any Lua garbage.
+
+// Returns table at key, creates it if missing
+template <typename Key>
+static sol::table Subtable(sol::state& lua, sol::table& parent, const Key& key) {
+    sol::optional<sol::table> existing = parent[key];
+    if (existing) {
+        return *existing;
+    }
+    auto table = lua.create_table();
+    parent[key] = table;
+    return table;
+}
+
+// Assigns only when changed, avoids pushing new strings
+template <typename T>
+static void SetIfChanged(sol::table& table, const char* key, const T& value) {
+    const sol::optional<T> current = table[key];
+    if (!current || *current != value) {
+        table[key] = value;
+    }
+}
+
+// Removes array entries after size
+static void TrimArray(sol::table& table, size_t size) {
+    for (auto i = table.size(); i > size; i--) {
+        table[i] = sol::lua_nil;
+    }
+}
+
 void ScriptContextImpl::Publish(const std::string_view name, const Displays& displays) {
-    auto displaysTable = m_lua.create_table();
+    IncreaseVersion(name);
+    PublishWorkers(name, displays);
+#ifdef ZEN_LUAJIT
+    PublishFfi(m_ffiDisplays, name, displays);
+    return;
+#endif
+    if (m_isLazy) {
+        m_lazy.Publish(m_lua, name, displays);
+        return;
+    }
+    sol::table zen = m_lua["zen"];
+    auto displaysTable = Subtable(m_lua, zen, name);
     for (const auto& display : displays) {
-        auto displayTable = m_lua.create_table();
-        auto workspacesTable = m_lua.create_table();
+        auto displayTable = Subtable(m_lua, displaysTable, display.name);
+        auto workspacesTable = Subtable(m_lua, displayTable, "workspaces");
+        size_t workspaceIndex = 0;
         for (const auto& workspace : display.workspaces) {
-            auto workspaceTable = m_lua.create_table();
-            auto applicationsTable = m_lua.create_table();
+            auto workspaceTable = Subtable(m_lua, workspacesTable, ++workspaceIndex);
+            auto applicationsTable = Subtable(m_lua, workspaceTable, "applications");
+            size_t applicationIndex = 0;
             for (const auto& application : workspace.applications) {
-                auto applicationTable = m_lua.create_table();
-                applicationTable["name"] = application.name;
-                applicationTable["focus"] = application.isFocused;
-                applicationTable["alert"] = application.isAlerted;
-                applicationTable["appid"] = application.appId;
-                applicationsTable.add(applicationTable);
+                auto applicationTable = Subtable(m_lua, applicationsTable, ++applicationIndex);
+                SetIfChanged(applicationTable, "name", application.name);
+                SetIfChanged(applicationTable, "focus", application.isFocused);
+                SetIfChanged(applicationTable, "alert", application.isAlerted);
+                SetIfChanged(applicationTable, "appid", application.appId);
             }
-            workspaceTable["name"] = workspace.name;
-            workspaceTable["focus"] = workspace.isFocused;
-            workspaceTable["alert"] = workspace.isAlerted;
-            workspaceTable["applications"] = applicationsTable;
-            workspacesTable.add(workspaceTable);
+            TrimArray(applicationsTable, applicationIndex);
+            SetIfChanged(workspaceTable, "name", workspace.name);
+            SetIfChanged(workspaceTable, "focus", workspace.isFocused);
+            SetIfChanged(workspaceTable, "visible", workspace.isVisible);
+            SetIfChanged(workspaceTable, "alert", workspace.isAlerted);
         }
-        displayTable["workspaces"] = workspacesTable;
+        TrimArray(workspacesTable, workspaceIndex);
         spdlog::debug("Display {} focus: {}", display.name, display.isFocused);
-        displayTable["focus"] = display.isFocused;
-        displayTable["alert"] = display.isAlerted;
-        displaysTable[display.name] = displayTable;
+        SetIfChanged(displayTable, "focus", display.isFocused);
+        SetIfChanged(displayTable, "alert", display.isAlerted);
+    }
+    // Remove displays that are gone
+    std::vector<std::string> gone;
+    displaysTable.for_each([&displays, &gone](const sol::object& key, const sol::object&) {
+        auto displayName = key.as<std::string>();
+        auto it = std::find_if(displays.begin(), displays.end(),
+                               [&displayName](const auto& d) { return d.name == displayName; });
+        if (it == displays.end()) {
+            gone.push_back(std::move(displayName));
+        }
+    });
+    for (const auto& displayName : gone) {
+        displaysTable[displayName] = sol::lua_nil;
     }
-    m_lua["zen"][name] = displaysTable;
 }
 
 void ScriptContextImpl::Publish(const std::string_view name, const PowerState& power) {
-    auto table = m_lua.create_table();
-    table["isAlerted"] = power.IsAlerted;
-    table["isCharging"] = power.IsCharging;
-    table["isPluggedIn"] = power.IsPluggedIn;
-    table["capacity"] = (int)power.Capacity;
-    m_lua["zen"][name] = table;
+    IncreaseVersion(name);
+    PublishWorkers(name, power);
+    Bind(name, "isAlerted", power.IsAlerted);
+    Bind(name, "isCharging", power.IsCharging);
+    Bind(name, "isPluggedIn", power.IsPluggedIn);
+    Bind(name, "capacity", (double)power.Capacity);
+#ifdef ZEN_LUAJIT
+    PublishFfi(m_ffiPower, name, power);
+    return;
+#endif
+    sol::table zen = m_lua["zen"];
+    auto table = Subtable(m_lua, zen, name);
+    SetIfChanged(table, "isAlerted", power.IsAlerted);
+    SetIfChanged(table, "isCharging", power.IsCharging);
+    SetIfChanged(table, "isPluggedIn", power.IsPluggedIn);
+    SetIfChanged(table, "capacity", (int)power.Capacity);
 }
 
 void ScriptContextImpl::Publish(const std::string_view name, const AudioState& audio) {
-    auto table = m_lua.create_table();
-    table["muted"] = audio.Muted;
-    table["volume"] = audio.Volume;
-    table["port"] = audio.PortType;
-    m_lua["zen"][name] = table;
+    IncreaseVersion(name);
+    PublishWorkers(name, audio);
+    Bind(name, "muted", audio.Muted);
+    Bind(name, "volume", (double)audio.Volume);
+    Bind(name, "port", audio.PortType);
+#ifdef ZEN_LUAJIT
+    PublishFfi(m_ffiAudio, name, audio);
+    return;
+#endif
+    sol::table zen = m_lua["zen"];
+    auto table = Subtable(m_lua, zen, name);
+    SetIfChanged(table, "muted", audio.Muted);
+    SetIfChanged(table, "volume", audio.Volume);
+    SetIfChanged(table, "port", audio.PortType);
 }
 
 void ScriptContextImpl::Publish(const std::string_view name, const KeyboardState& keyboard) {
-    auto table = m_lua.create_table();
-    table["layout"] = keyboard.layout;
-    m_lua["zen"][name] = table;
+    IncreaseVersion(name);
+    PublishWorkers(name, keyboard);
+    Bind(name, "layout", keyboard.layout);
+    sol::table zen = m_lua["zen"];
+    auto table = Subtable(m_lua, zen, name);
+    SetIfChanged(table, "layout", keyboard.layout);
 }
+
 void ScriptContextImpl::Publish(const std::string_view name, const Networks& networks) {
-    auto networksTable = m_lua.create_table();
+    IncreaseVersion(name);
+    PublishWorkers(name, networks);
+#ifdef ZEN_LUAJIT
+    PublishFfi(m_ffiNetworks, name, networks);
+    return;
+#endif
+    if (m_isLazy) {
+        m_lazy.Publish(m_lua, name, networks);
+        return;
+    }
+    sol::table zen = m_lua["zen"];
+    auto networksTable = Subtable(m_lua, zen, name);
+    size_t index = 0;
     for (const auto& keyValue : networks) {
         const auto& interface = keyValue.first;
         const auto& network = keyValue.second;
-        auto networkTable = m_lua.create_table();
-        networkTable["up"] = network.isUp;
-        networkTable["interface"] = interface;
-        networkTable["address"] = network.address;
-        networksTable.add(networkTable);
+        auto networkTable = Subtable(m_lua, networksTable, ++index);
+        SetIfChanged(networkTable, "up", network.isUp);
+        SetIfChanged(networkTable, "interface", interface);
+        SetIfChanged(networkTable, "address", network.address);
     }
-    m_lua["zen"][name] = networksTable;
+    TrimArray(networksTable, index);
 }
 
-std::string HtmlEscape(sol::optional<std::string> maybeString) {
+void ScriptContextImpl::Publish(const std::string_view name, const Alerts& alerts) {
+    IncreaseVersion(name);
+    PublishWorkers(name, alerts);
+    sol::table zen = m_lua["zen"];
+    auto alertsTable = Subtable(m_lua, zen, name);
+    size_t index = 0;
+    for (const auto& alert : alerts) {
+        auto alertTable = Subtable(m_lua, alertsTable, ++index);
+        SetIfChanged(alertTable, "kind", std::string(AlertKindName(alert.kind)));
+        SetIfChanged(alertTable, "priority", std::string(AlertPriorityName(alert.priority)));
+        SetIfChanged(alertTable, "id", alert.id);
+        SetIfChanged(alertTable, "message", alert.message);
+    }
+    TrimArray(alertsTable, index);
+}
+
+void ScriptContextImpl::Publish(const std::string_view name,
+                                const std::vector<CallStats>& stats) {
+    IncreaseVersion(name);
+    PublishWorkers(name, stats);
+    sol::table zen = m_lua["zen"];
+    auto statsTable = Subtable(m_lua, zen, name);
+    SetIfChanged(statsTable, "heap", (int64_t)lua_gc(m_lua, LUA_GCCOUNT, 0) * 1024);
+    auto callsTable = Subtable(m_lua, statsTable, "calls");
+    size_t index = 0;
+    for (const auto& call : stats) {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        auto callTable = Subtable(m_lua, callsTable, ++index);
+        SetIfChanged(callTable, "name", call.name);
+        SetIfChanged(callTable, "calls", (int64_t)call.calls);
+        SetIfChanged(callTable, "us", (int64_t)duration_cast<microseconds>(call.time).count());
+        SetIfChanged(callTable, "max_us",
+                     (int64_t)duration_cast<microseconds>(call.maxTime).count());
+        SetIfChanged(callTable, "bytes", (int64_t)call.allocated);
+    }
+    TrimArray(callsTable, index);
+}
+
+// Tables nested deeper are published empty, guards against cycles
+static constexpr int MAX_SCRIPT_VALUE_DEPTH = 16;
+
+static ScriptValue ToScriptValue(const sol::object& object, int depth = 0) {
+    ScriptValue value;
+    switch (object.get_type()) {
+        case sol::type::boolean:
+            value.scalar = object.as<bool>();
+            break;
+        case sol::type::number: {
+#if LUA_VERSION_NUM >= 503
+            object.push();
+            const bool isInteger = lua_isinteger(object.lua_state(), -1);
+            lua_pop(object.lua_state(), 1);
+            if (isInteger) {
+                value.scalar = object.as<int64_t>();
+                break;
+            }
+#endif
+            value.scalar = object.as<double>();
+            break;
+        }
+        case sol::type::string:
+            value.scalar = object.as<std::string>();
+            break;
+        case sol::type::table:
+            value.isTable = true;
+            if (depth >= MAX_SCRIPT_VALUE_DEPTH) {
+                break;
+            }
+            object.as<sol::table>().for_each([&](const sol::object& key, const sol::object& v) {
+                if (key.get_type() == sol::type::string || key.get_type() == sol::type::number) {
+                    value.table.emplace_back(ToScriptValue(key), ToScriptValue(v, depth + 1));
+                }
+            });
+            break;
+        default:
+            // Functions and userdata are not copied
+            break;
+    }
+    return value;
+}
+
+static sol::object ToLua(sol::state& lua, const ScriptValue& value) {
+    if (value.isTable) {
+        auto table = lua.create_table();
+        for (const auto& keyValue : value.table) {
+            table[ToLua(lua, keyValue.first)] = ToLua(lua, keyValue.second);
+        }
+        return table;
+    }
+    return std::visit(
+        [&lua](const auto& scalar) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(scalar)>, std::monostate>) {
+                return sol::make_object(lua, sol::lua_nil);
+            } else {
+                return sol::make_object(lua, scalar);
+            }
+        },
+        value.scalar);
+}
+
+// Replaced as a whole, sources defined in configuration are seldom published. Fields that
+// are not tables are bound for templates.
+void ScriptContextImpl::Publish(const std::string_view name, const ScriptValue& value) {
+    IncreaseVersion(name);
+    PublishWorkers(name, value);
+    sol::table zen = m_lua["zen"];
+    zen[name] = ToLua(m_lua, value);
+    for (const auto& keyValue : value.table) {
+        const auto field = std::get_if<std::string>(&keyValue.first.scalar);
+        if (!field || keyValue.second.isTable) {
+            continue;
+        }
+        const auto bound = std::visit(
+            [](const auto& scalar) -> BoundValue {
+                if constexpr (std::is_same_v<std::decay_t<decltype(scalar)>, int64_t>) {
+                    return (double)scalar;
+                } else {
+                    return scalar;
+                }
+            },
+            keyValue.second.scalar);
+        m_bound->Set(fmt::format("{}.{}", name, *field), bound);
+    }
+}
+
+bool ScriptContextImpl::CollectGarbage(std::chrono::microseconds budget) {
+    // Render workers share the budget
+    budget /= (int64_t)m_workers.size() + 1;
+    bool isCollecting = false;
+    for (auto& worker : m_workers) {
+        isCollecting = worker->CollectGarbage(budget) || isCollecting;
+    }
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    bool isFinished = false;
+    // Smallest steps to stay close to budget
+    do {
+        isFinished = lua_gc(m_lua, LUA_GCSTEP, 0) == 1;
+    } while (!isFinished && Clock::now() - start < budget);
+    // Stepping might restart the automatic collector
+    lua_gc(m_lua, LUA_GCSTOP, 0);
+    const auto elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+    Metrics::Shared().Set("lua.gc_us", elapsed.count());
+    Metrics::Shared().Add("lua.gc_steps");
+    Metrics::Shared().Add("lua.gc_cycles", isFinished ? 1 : 0);
+    if (!m_isWorker) {
+        Metrics::Shared().Set("lua.heap_kb", lua_gc(m_lua, LUA_GCCOUNT, 0));
+    }
+    return !isFinished || isCollecting;
+}
+
+sol::object ScriptContextImpl::Spawn(const sol::table& argvTable,
+                                     sol::optional<sol::table> options) {
+    if (!m_mainLoop) {
+        spdlog::error("zen.spawn is not available while loading configuration");
+        return sol::lua_nil;
+    }
+    std::vector<std::string> argv;
+    for (size_t i = 0; i < argvTable.size(); i++) {
+        const sol::optional<std::string> arg = argvTable[i + 1];
+        if (!arg) {
+            spdlog::error("zen.spawn arguments must be strings");
+            return sol::lua_nil;
+        }
+        argv.push_back(*arg);
+    }
+    const sol::object onOutput = options ? (*options)["stdout"] : sol::object();
+    const sol::object onExit = options ? (*options)["on_exit"] : sol::object();
+    const auto outputId = KeepCallback(onOutput);
+    const auto exitId = KeepCallback(onExit);
+    Process::Callbacks callbacks;
+    if (outputId) {
+        callbacks.onOutput = [kept = std::weak_ptr(m_callbacks), outputId](auto line) {
+            InvokeCallback(kept, outputId, "spawn stdout", line);
+        };
+    }
+    // Always set to drop the callbacks when done
+    callbacks.onExit = [kept = std::weak_ptr(m_callbacks), outputId, exitId](int status) {
+        InvokeCallback(kept, exitId, "spawn exit", status);
+        DropCallbacks(kept, {outputId, exitId});
+    };
+    auto process = Process::Spawn(m_mainLoop, argv, std::move(callbacks));
+    if (!process) {
+        return sol::lua_nil;
+    }
+    return sol::make_object(m_lua, process->Pid());
+}
+
+// Dependencies are source names or field paths. Fields bound for templates are versioned by
+// change, other paths by the source they belong to.
+sol::object ScriptContextImpl::Cache(const std::string& key, const sol::table& deps,
+                                     const sol::protected_function& function) {
+    std::vector<uint64_t> versions;
+    for (size_t i = 0; i < deps.size(); i++) {
+        const std::string dep = deps[i + 1];
+        const auto fieldVersion = m_bound->Version(dep);
+        if (fieldVersion != 0) {
+            versions.push_back(fieldVersion);
+            continue;
+        }
+        auto it = m_versions.find(std::string_view(dep).substr(0, dep.find('.')));
+        versions.push_back(it != m_versions.end() ? it->second : 0);
+    }
+    auto cached = m_cacheVersions.find(key);
+    if (cached != m_cacheVersions.end() && cached->second == versions) {
+        Metrics::Shared().Add("lua.cache_hits");
+        return m_cache[key];
+    }
+    Metrics::Shared().Add("lua.cache_misses");
+    sol::protected_function_result result = function();
+    if (!result.valid()) {
+        sol::error e = result;
+        spdlog::error("Error computing zen.cache entry {}: {}", key, e.what());
+        return sol::lua_nil;
+    }
+    sol::object value = result;
+    m_cache[key] = value;
+    m_cacheVersions[key] = std::move(versions);
+    return value;
+}
+
+// Lines of a file as a table shared by all calls until the file changes, nil if the file
+// can not be read
+sol::object ScriptContextImpl::Lines(const std::string& path) {
+    auto file = FileCache::Shared().Read(path);
+    if (!file) {
+        m_lines.erase(path);
+        return sol::lua_nil;
+    }
+    auto it = m_lines.find(path);
+    if (it != m_lines.end() && it->second.first == file) {
+        return it->second.second;
+    }
+    auto lines = m_lua.create_table((int)file->lines.size(), 0);
+    for (size_t i = 0; i < file->lines.size(); i++) {
+        lines[i + 1] = file->lines[i];
+    }
+    m_lines.insert_or_assign(path, std::make_pair(file, lines));
+    return lines;
+}
+
+// Shortest interval of zen.every
+static constexpr std::chrono::milliseconds MIN_TIMER_INTERVAL{10};
+
+// Returned by zen.every and zen.after. Dropping the handle keeps the timer running.
+struct TimerHandle {
+    void Cancel() {
+        if (auto running = timers.lock()) {
+            running->Cancel(timer);
+        }
+        ScriptContextImpl::DropCallbacks(callbacks, {callback});
+    }
+
+    std::weak_ptr<Timers> timers;
+    uint64_t timer;
+    std::weak_ptr<sol::table> callbacks;
+    int callback;
+};
+
+sol::object ScriptContextImpl::StartTimer(const char* what, double delayMs, double intervalMs,
+                                          const sol::object& function,
+                                          sol::optional<sol::table> options) {
+    if (m_isWorker) {
+        return sol::lua_nil;
+    }
+    if (!m_timers) {
+        spdlog::error("{} is not available until attached to the main loop", what);
+        return sol::lua_nil;
+    }
+    const auto callback = KeepCallback(function);
+    if (!callback) {
+        spdlog::error("{} requires a function", what);
+        return sol::lua_nil;
+    }
+    const bool isRepeating = intervalMs > 0;
+    const auto delay = std::chrono::milliseconds((int64_t)std::max(delayMs, 0.0));
+    // Repeating timers are not allowed to spin the main loop
+    const auto interval = isRepeating ? std::max(std::chrono::milliseconds((int64_t)intervalMs),
+                                                 MIN_TIMER_INTERVAL)
+                                      : std::chrono::milliseconds(0);
+    const bool isAlways = options && options->get_or("always", false);
+    if (!m_hasTimers && !m_workers.empty()) {
+        WarnTimersWithWorkers();
+    }
+    m_hasTimers = true;
+    const auto timer = m_timers->Start(
+        delay, interval, isAlways,
+        [kept = std::weak_ptr(m_callbacks), callback, isRepeating, what]() {
+            // Stopped when the state is replaced by a reloaded configuration
+            if (kept.expired()) {
+                return false;
+            }
+            InvokeCallback(kept, callback, what);
+            if (!isRepeating) {
+                DropCallbacks(kept, {callback});
+            }
+            return isRepeating;
+        });
+    return sol::make_object(m_lua, TimerHandle{.timers = m_timers,
+                                               .timer = timer,
+                                               .callbacks = m_callbacks,
+                                               .callback = callback});
+}
+
+int ScriptContextImpl::KeepCallback(const sol::object& function) {
+    if (function.get_type() != sol::type::function) {
+        return 0;
+    }
+    const auto id = m_nextCallback++;
+    (*m_callbacks)[id] = function;
+    return id;
+}
+
+template <typename... Args>
+void ScriptContextImpl::InvokeCallback(const std::weak_ptr<sol::table>& callbacks, int id,
+                                       const char* what, Args&&... args) {
+    auto table = callbacks.lock();
+    if (!table || id == 0) {
+        return;
+    }
+    sol::protected_function function = (*table)[id];
+    sol::protected_function_result result = function(std::forward<Args>(args)...);
+    if (!result.valid()) {
+        sol::error e = result;
+        spdlog::error("Error in {} handler: {}", what, e.what());
+    }
+}
+
+void ScriptContextImpl::DropCallbacks(const std::weak_ptr<sol::table>& callbacks,
+                                      std::initializer_list<int> ids) {
+    if (auto table = callbacks.lock()) {
+        for (auto id : ids) {
+            (*table)[id] = sol::lua_nil;
+        }
+    }
+}
+
+// Markup is built in a buffer reused between calls, results are copied once into Lua
+static std::string& MarkupBuffer() {
+    static thread_local std::string buffer;
+    buffer.clear();
+    return buffer;
+}
+
+// Strings and numbers, anything else is skipped
+static bool AppendValue(std::string& out, const sol::object& value, bool isEscaped) {
+    switch (value.get_type()) {
+        case sol::type::string:
+            if (isEscaped) {
+                Util::AppendHtmlEscaped(out, value.as<std::string_view>());
+            } else {
+                out.append(value.as<std::string_view>());
+            }
+            return true;
+        case sol::type::number:
+            fmt::format_to(std::back_inserter(out), "{}", value.as<double>());
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::string_view HtmlEscape(sol::optional<std::string_view> maybeString) {
     if (!maybeString) {
         spdlog::error("html_encode requires string");
         return "";
     }
-    return Util::HtmlEscape(*maybeString);
+    auto& out = MarkupBuffer();
+    Util::AppendHtmlEscaped(out, *maybeString);
+    return out;
+}
+
+// Pango span attributes, written in this order
+static const char* SPAN_ATTRIBUTES[] = {"font",  "font_family", "size",       "weight",
+                                        "style", "rise",        "color",      "background",
+                                        "alpha", "fgalpha",     "bgalpha",    "underline",
+                                        "strikethrough"};
+
+// Span with text as markup, or escaped when escape is set
+std::string_view Span(const sol::table& t) {
+    auto& out = MarkupBuffer();
+    out.append("<span");
+    for (auto name : SPAN_ATTRIBUTES) {
+        const sol::object value = t[name];
+        if (value.get_type() == sol::type::lua_nil) {
+            continue;
+        }
+        out.append(" ").append(name).append("='");
+        AppendValue(out, value, true);
+        out.append("'");
+    }
+    out.append(">");
+    AppendValue(out, t["text"], t.get_or("escape", false));
+    out.append("</span>");
+    return out;
+}
+
+// Strings and numbers concatenated, arrays are concatenated in place
+std::string_view Concat(sol::variadic_args args) {
+    auto& out = MarkupBuffer();
+    for (const auto& arg : args) {
+        const sol::object value = arg;
+        if (value.get_type() != sol::type::table) {
+            AppendValue(out, value, false);
+            continue;
+        }
+        const auto array = value.as<sol::table>();
+        for (size_t i = 0; i < array.size(); i++) {
+            AppendValue(out, array[i + 1], false);
+        }
+    }
+    return out;
+}
+
+// Size of markup, or of runs concatenated, as laid out by a markup with the same bounds.
+// Goes through the layout cache, rendering the measured markup does not shape it again.
+std::tuple<int, int, int> Measure(const sol::object& markupOrRuns,
+                                  sol::optional<sol::table> options) {
+    auto& markup = MarkupBuffer();
+    if (markupOrRuns.get_type() == sol::type::table) {
+        const auto runs = markupOrRuns.as<sol::table>();
+        for (size_t i = 0; i < runs.size(); i++) {
+            AppendValue(markup, runs[i + 1], false);
+        }
+    } else if (!AppendValue(markup, markupOrRuns, false)) {
+        spdlog::error("measure requires markup or runs");
+        return {0, 0, 0};
+    }
+    const auto bounds = options ? TextBoundsFromTable(*options) : TextBounds{};
+    const auto layout = LayoutCache::Shared().Lookup(markup, bounds);
+    return {layout->cx, layout->cy, layout->baseline};
 }
 
-std::unique_ptr<ScriptContext> ScriptContext::Create() {
+// Content of a file, nil if it can not be read. Cached until the file changes.
+static sol::object ReadFile(const std::string& path, sol::this_state L) {
+    auto file = FileCache::Shared().Read(path);
+    if (!file) {
+        return sol::lua_nil;
+    }
+    return sol::make_object(L, std::string_view(file->content));
+}
+
+static std::unique_ptr<ScriptContextImpl> CreateImpl() {
+    auto allocator = std::make_unique<LuaAllocator>();
+#ifdef ZEN_LUAJIT
     sol::state lua;
+#else
+    sol::state lua(sol::default_at_panic, &LuaAllocator::Alloc, allocator.get());
+#endif
+    // Collected in steps between frames, see CollectGarbage
+    lua_gc(lua, LUA_GCSTOP, 0);
     lua.open_libraries();
+    BytecodeCache::Shared().InstallSearcher(lua);
+    // Blocks the main loop until the command exits, still allowed for configurations
+    sol::protected_function execute = lua["os"]["execute"];
+    lua["os"]["execute"] = [execute](sol::variadic_args args) {
+        if (auto callback = CallProbe::Current()) {
+            spdlog::warn("os.execute in {} blocks zenway until it exits, use zen.spawn",
+                         callback->name);
+        }
+        return execute(args);
+    };
+    LazySources::Register(lua);
     // Build utilities
     auto util = lua.create_table();
     util.set_function("html_escape", &HtmlEscape);
+    util.set_function("span", &Span);
+    util.set_function("concat", &Concat);
     auto zen = lua.create_table();
     zen["u"] = util;
+    zen.set_function("measure", &Measure);
+    auto fs = lua.create_table();
+    fs.set_function("read", &ReadFile);
+    zen["fs"] = fs;
+    // Kept in the registry instead of as a global
+    auto types = lua.create_table();
+    lua.registry()["zen.types"] = types;
+    types.new_usertype<TimerHandle>("timer", sol::no_constructor, "cancel", &TimerHandle::Cancel);
+    types.new_usertype<BoxStyle>("style", sol::no_constructor);
+    zen.set_function("style", &BoxStyleFromTable);
     // Expose root api for configuration to Lua
     lua["zen"] = zen;
-    return std::unique_ptr<ScriptContext>(new ScriptContextImpl(std::move(lua)));
+    lua.safe_script(TEMPLATE_PRELUDE, "=template");
+    auto scriptContext = std::make_unique<ScriptContextImpl>(std::move(allocator), std::move(lua));
+#ifdef ZEN_LUAJIT
+    if (!scriptContext->InitializeFfi()) {
+        return nullptr;
+    }
+#endif
+    return scriptContext;
+}
+
+std::unique_ptr<ScriptContext> ScriptContext::Create() { return CreateImpl(); }
+
+class SourcePollerImpl : public SourcePoller {
+   public:
+    SourcePollerImpl(std::unique_ptr<ScriptContextImpl> context, sol::protected_function poll,
+                     CallStats& stats)
+        : m_context(std::move(context)), m_poll(std::move(poll)), m_stats(stats) {}
+
+    // Not probed like callbacks, polling is where blocking calls belong
+    std::optional<ScriptValue> Poll() override {
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+        const auto allocated = AllocatedBytes(m_poll.lua_state());
+        sol::protected_function_result result = m_poll();
+        ScriptStats::Shared().Record(m_stats, Clock::now() - start,
+                                     AllocatedBytes(m_poll.lua_state()) - allocated);
+        if (!result.valid()) {
+            sol::error e = result;
+            spdlog::error("Failed to poll {}: {}", m_stats.name, e.what());
+            return std::nullopt;
+        }
+        return ToScriptValue(result.get<sol::object>());
+    }
+
+   private:
+    std::unique_ptr<ScriptContextImpl> m_context;
+    sol::protected_function m_poll;  // Released before the state
+    CallStats& m_stats;
+};
+
+std::unique_ptr<SourcePoller> SourcePoller::Create(const char* path, const std::string& source) {
+    auto context = CreateImpl();
+    if (!context) {
+        return nullptr;
+    }
+    context->SetWorker();
+    if (!context->Execute(path)) {
+        return nullptr;
+    }
+    auto poll = context->PollFunction(source);
+    if (!poll) {
+        spdlog::error("No poll function for source {}", source);
+        return nullptr;
+    }
+    // Nothing is drawn from this state, collect as usual
+    lua_gc(poll->lua_state(), LUA_GCRESTART, 0);
+    auto& stats = ScriptStats::Shared().Register(source + ".poll");
+    return std::make_unique<SourcePollerImpl>(std::move(context), *poll, stats);
 }
@@ -1,9 +1,16 @@
 #pragma once
 
+#include <chrono>
 #include <map>
 #include <memory>
+#include <optional>
+#include <utility>
+#include <variant>
 
 #include "zen/Configuration.h"
+#include "zen/MainLoop.h"
+#include "zen/ScriptStats.h"
+#include "zen/Timers.h"
 
 // DO NOT expose sol2 types here, they should be kept in .cpp file
 // Reason for above is that sol2 sometimes messes with code formatter/LSP in
@@ -21,10 +28,12 @@ struct Application {
 };
 
 struct Workspace {
-    Workspace(const std::string name_) : name(name_), isFocused(false), isAlerted(false) {}
+    Workspace(const std::string name_)
+        : name(name_), isFocused(false), isAlerted(false), isVisible(false) {}
     std::string name;
     bool isFocused;  // Has the focused application
     bool isAlerted;  // Has an alerted application
+    bool isVisible;  // Currently shown on its display
     std::vector<Application> applications;
 };
 
@@ -72,6 +81,25 @@ struct NetworkState {
 };
 using Networks = std::map<std::string, NetworkState>;
 
+// Copy of a Lua value that can be moved between Lua states. Tables keep their pairs in the
+// order Lua iterated them, keys are strings or numbers.
+struct ScriptValue {
+    // Monostate for nil and tables, Lua integers are kept apart from floats
+    std::variant<std::monostate, bool, int64_t, double, std::string> scalar;
+    std::vector<std::pair<ScriptValue, ScriptValue>> table;
+    bool isTable = false;
+
+    bool operator==(const ScriptValue& other) const = default;
+};
+
+struct lua_State;
+
+// Converts the render result at index of the stack, markup or a render table. Tables are read
+// in one pass each with lua_next. The lookups variant reads each property by name through
+// sol2, it is used for tables with metatables and kept to compare with in benchmarks.
+std::unique_ptr<Renderable> RenderableFromLua(lua_State* L, int index);
+std::unique_ptr<Renderable> RenderableFromLuaLookups(lua_State* L, int index);
+
 class ScriptContext {
    public:
     ScriptContext() {}
@@ -83,4 +111,26 @@ class ScriptContext {
     virtual void Publish(const std::string_view name, const AudioState& audio) = 0;
     virtual void Publish(const std::string_view name, const KeyboardState& keyboard) = 0;
     virtual void Publish(const std::string_view name, const Networks& networks) = 0;
+    virtual void Publish(const std::string_view name, const Alerts& alerts) = 0;
+    virtual void Publish(const std::string_view name, const std::vector<CallStats>& stats) = 0;
+    // Sources defined in configuration
+    virtual void Publish(const std::string_view name, const ScriptValue& value) = 0;
+    // Lua is collected incrementally when idle. Steps the collector for about budget and
+    // returns true if the cycle is not finished.
+    virtual bool CollectGarbage(std::chrono::microseconds budget) = 0;
+    // Lua functions waiting on io or time, like zen.spawn and zen.every, need the main loop
+    // and fail until attached
+    virtual void Attach(std::shared_ptr<MainLoop> mainLoop, std::shared_ptr<Timers> timers) = 0;
+};
+
+// Calls the poll function of a source defined in configuration. Configuration is executed
+// in a Lua state of its own, so that poll can be called on another thread than the script
+// context while it is drawing.
+class SourcePoller {
+   public:
+    // Null if configuration fails or has no poll function for source
+    static std::unique_ptr<SourcePoller> Create(const char* path, const std::string& source);
+    virtual ~SourcePoller() {}
+    // Copy of the returned value, nullopt if poll failed
+    virtual std::optional<ScriptValue> Poll() = 0;
 };
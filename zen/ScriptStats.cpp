@@ -0,0 +1,61 @@
+#include "zen/ScriptStats.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+void CallStats::Record(std::chrono::nanoseconds elapsed, int64_t allocatedBytes) {
+    calls++;
+    time += elapsed;
+    maxTime = std::max(maxTime, elapsed);
+    // Heap size based measurements can go negative when the collector runs during the call
+    allocated += std::max(allocatedBytes, (int64_t)0);
+}
+
+ScriptStats& ScriptStats::Shared() {
+    static ScriptStats stats;
+    return stats;
+}
+
+CallStats& ScriptStats::Register(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& stats = m_calls[name];
+    stats.name = name;
+    return stats;
+}
+
+void ScriptStats::Record(CallStats& stats, std::chrono::nanoseconds elapsed,
+                         int64_t allocatedBytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats.Record(elapsed, allocatedBytes);
+}
+
+std::vector<CallStats> ScriptStats::Snapshot() const {
+    std::vector<CallStats> snapshot;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (const auto& keyValue : m_calls) {
+        snapshot.push_back(keyValue.second);
+    }
+    lock.unlock();
+    std::stable_sort(snapshot.begin(), snapshot.end(),
+                     [](const auto& a, const auto& b) { return a.time > b.time; });
+    return snapshot;
+}
+
+void ScriptStats::Log() const {
+    spdlog::info("{:<32} {:>8} {:>10} {:>10} {:>10} {:>12}", "Lua callback", "calls", "total ms",
+                 "mean us", "max us", "bytes/call");
+    for (const auto& stats : Snapshot()) {
+        if (stats.calls == 0) {
+            continue;
+        }
+        spdlog::info("{:<32} {:>8} {:>10.1f} {:>10} {:>10} {:>12}", stats.name, stats.calls,
+                     duration_cast<microseconds>(stats.time).count() / 1000.0,
+                     duration_cast<microseconds>(stats.time).count() / stats.calls,
+                     duration_cast<microseconds>(stats.maxTime).count(),
+                     stats.allocated / stats.calls);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Cost of a single Lua callback, like the render function of a widget
+struct CallStats {
+    std::string name;  // <panel>.<widget>.<callback>
+    uint64_t calls = 0;
+    std::chrono::nanoseconds time{0};
+    std::chrono::nanoseconds maxTime{0};
+    uint64_t allocated = 0;  // Bytes allocated on the Lua heap
+
+    void Record(std::chrono::nanoseconds elapsed, int64_t allocatedBytes);
+    bool operator==(const CallStats& other) const = default;
+};
+
+// Process wide statistics of calls into Lua, for finding slow configurations. Calls are
+// recorded from render workers.
+class ScriptStats {
+   public:
+    static ScriptStats& Shared();
+
+    // Reference stays valid, registering the same name again returns the same stats
+    CallStats& Register(const std::string& name);
+    void Record(CallStats& stats, std::chrono::nanoseconds elapsed, int64_t allocatedBytes);
+    // Most expensive calls first
+    std::vector<CallStats> Snapshot() const;
+    void Log() const;
+
+   private:
+    ScriptStats() {}
+    mutable std::mutex m_mutex;
+    std::map<std::string, CallStats> m_calls;
+};
@@ -34,13 +34,19 @@ static const wl_surface_listener surface_listener = {
 std::unique_ptr<ShellSurface> ShellSurface::Create(const Registry &registry, wl_output *output,
                                                    PanelConfig panelConfig) {
     auto surface = wl_compositor_create_surface(registry.compositor);
-    auto shellSurface =
-        std::unique_ptr<ShellSurface>(new ShellSurface(output, surface, std::move(panelConfig)));
+    auto shellSurface = std::unique_ptr<ShellSurface>(
+        new ShellSurface(registry, output, surface, std::move(panelConfig)));
     wl_surface_add_listener(surface, &surface_listener, shellSurface.get());
     wl_surface_commit(surface);
     return shellSurface;
 }
 
+ShellSurface::~ShellSurface() {
+    Hide();
+    wl_surface_destroy(m_surface);
+    m_registry.FlushAndDispatchCommands();
+}
+
 void ShellSurface::OnShellConfigure(uint32_t cx, uint32_t cy) {
     spdlog::trace("Event zwlr_layer_surface::configure size {}x{}", cx, cy);
 };
@@ -54,81 +60,38 @@ bool ShellSurface::ClickSurface(wl_surface *surface, int x, int y) {
     if (surface != m_surface) {
         return false;
     }
-    // Check what widget
-    int i = 0;
-    for (const auto &w : m_drawn.widgets) {
-        if (w.position.Contains(x, y)) {
-            auto &widget = m_panelConfig.widgets.at(i);
-            if (widget.click) {
-                // Widget has a click handler. There might be inner more
-                // specific targets, find the tag of the correct one.
-                std::string tag = "";
-                for (const auto &t : w.targets) {
-                    if (t.position.Contains(x, y)) {
-                        tag = t.tag;
-                        break;
-                    }
-                }
-                spdlog::debug("Click in widget, tag: {}", tag);
-                widget.click(tag);
-            }
-            break;
-        }
-        i++;
-    }
+    Click(x, y);
     // Return true even if no widget was found to stop trying other surfaces
     return true;
 }
 
-// TODO: Refactor to share some code between Click and Wheel
 bool ShellSurface::WheelSurface(wl_surface *surface, int x, int y, int value) {
     if (surface != m_surface) {
         return false;
     }
-    // Check what widget
-    int i = 0;
-    for (const auto &w : m_drawn.widgets) {
-        if (w.position.Contains(x, y)) {
-            auto &widget = m_panelConfig.widgets.at(i);
-            if (widget.wheel) {
-                // Widget has a wheel handler. There might be inner more
-                // specific targets, find the tag of the correct one.
-                std::string tag = "";
-                for (const auto &t : w.targets) {
-                    if (t.position.Contains(x, y)) {
-                        tag = t.tag;
-                        break;
-                    }
-                }
-                spdlog::debug("Wheel in widget, tag: {}", tag);
-                widget.wheel(tag, value);
-            }
-            break;
-        }
-        i++;
-    }
+    Wheel(x, y, value);
     // Return true even if no widget was found to stop trying other surfaces
     return true;
 }
 
-void ShellSurface::Draw(const Registry &registry, BufferPool &bufferPool,
-                        const std::string &outputName) {
+void ShellSurface::Draw(BufferPool &bufferPool, const std::string &outputName,
+                        const std::vector<bool> &dirtyWidgets) {
     if (m_isClosed) {
         return;
     }
     m_drawn.widgets.clear();
-    if (!Draw::Panel(m_panelConfig, outputName, bufferPool, m_drawn)) {
+    if (!Draw::Panel(m_panelConfig, outputName, bufferPool, m_drawn, dirtyWidgets)) {
         // Nothing drawn for this output
         return;
     }
     if (!m_layer) {
         m_layer = zwlr_layer_shell_v1_get_layer_surface(
-            registry.shell, m_surface, m_output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, "namespace");
+            m_registry.shell, m_surface, m_output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, "namespace");
         zwlr_layer_surface_v1_add_listener(m_layer, &layer_listener, this);
         zwlr_layer_surface_v1_set_size(m_layer, 1, 1);
         zwlr_layer_surface_v1_set_anchor(m_layer, ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT);
         wl_surface_commit(m_surface);
-        registry.FlushAndDispatchCommands();
+        m_registry.FlushAndDispatchCommands();
     }
     const auto &size = m_drawn.size;
     Size damage;
@@ -175,21 +138,21 @@ void ShellSurface::Draw(const Registry &registry, BufferPool &bufferPool,
     if (m_inputRegion) {
         wl_region_destroy(m_inputRegion);
     }
-    m_inputRegion = wl_compositor_create_region(registry.compositor);
+    m_inputRegion = wl_compositor_create_region(m_registry.compositor);
     wl_region_add(m_inputRegion, 0, 0, size.cx, size.cy);
     wl_surface_set_input_region(m_surface, m_inputRegion);
     // Commit changes
     wl_surface_commit(m_surface);
-    registry.FlushAndDispatchCommands();
+    m_registry.FlushAndDispatchCommands();
     m_previousDamage = size;
 }
 
-void ShellSurface::Hide(const Registry &registry) {
+void ShellSurface::Hide() {
     if (!m_layer) return;
     zwlr_layer_surface_v1_destroy(m_layer);
     wl_surface_attach(m_surface, NULL, 0, 0);
     m_layer = nullptr;
     wl_region_destroy(m_inputRegion);
     m_inputRegion = nullptr;
-    registry.FlushAndDispatchCommands();
+    m_registry.FlushAndDispatchCommands();
 }
@@ -7,16 +7,19 @@
 #include <memory>
 
 #include "zen/Configuration.h"
-#include "zen/Draw.h"
+#include "zen/Surface.h"
 
 class Registry;
 
-class ShellSurface {
+// Panel surface on a wlr layer shell
+class ShellSurface : public Surface {
    public:
     static std::unique_ptr<ShellSurface> Create(const Registry &registry, wl_output *output,
                                                 PanelConfig panelConfiguration);
-    void Draw(const Registry &registry, BufferPool &bufferPool, const std::string &outputName);
-    void Hide(const Registry &registry);
+    virtual ~ShellSurface();
+    void Draw(BufferPool &bufferPool, const std::string &outputName,
+              const std::vector<bool> &dirtyWidgets) override;
+    void Hide() override;
 
     void OnShellConfigure(uint32_t cx, uint32_t cy);
     void OnClosed();
@@ -25,21 +28,22 @@ class ShellSurface {
     bool WheelSurface(wl_surface *surface, int x, int y, int value);
 
    private:
-    ShellSurface(wl_output *output, wl_surface *surface, PanelConfig panelConfiguration)
-        : m_output(output),
+    ShellSurface(const Registry &registry, wl_output *output, wl_surface *surface,
+                 PanelConfig panelConfiguration)
+        : Surface(std::move(panelConfiguration)),
+          m_registry(registry),
+          m_output(output),
           m_surface(surface),
           m_layer(nullptr),
           m_inputRegion(nullptr),
           m_isClosed(false),
-          m_previousDamage{},
-          m_panelConfig(std::move(panelConfiguration)) {}
+          m_previousDamage{} {}
 
+    const Registry &m_registry;
     wl_output *m_output;
     wl_surface *m_surface;
     zwlr_layer_surface_v1 *m_layer;
     wl_region *m_inputRegion;
     bool m_isClosed;
     Size m_previousDamage;
-    PanelConfig m_panelConfig;
-    DrawnPanel m_drawn;
 };
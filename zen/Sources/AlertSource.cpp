@@ -0,0 +1,137 @@
+#include "zen/Sources/AlertSource.h"
+
+#include <spdlog/spdlog.h>
+#include <sys/timerfd.h>
+
+#include <algorithm>
+#include <cstring>
+
+std::shared_ptr<AlertSource> AlertSource::Create(std::shared_ptr<MainLoop> mainloop,
+                                                 const AlertsConfig& config) {
+    auto fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd == -1) {
+        spdlog::error("Failed to create timer: {}", strerror(errno));
+        return nullptr;
+    }
+    auto source = std::shared_ptr<AlertSource>(new AlertSource(fd, config));
+    mainloop->RegisterIoHandler(fd, "AlertSource", source);
+    // Publish empty set of alerts
+    source->m_drawn = source->m_published = false;
+    return source;
+}
+
+AlertSource::~AlertSource() { close(m_timerfd); }
+
+bool AlertSource::Apply(const std::vector<AlertEvent>& events) {
+    bool changed = false;
+    for (const auto& event : events) {
+        const auto& alert = event.alert;
+        auto it = std::find_if(m_active.begin(), m_active.end(), [&alert](const auto& active) {
+            return active.alert.kind == alert.kind && active.alert.id == alert.id;
+        });
+        if (!event.isRaised) {
+            if (it != m_active.end()) {
+                spdlog::info("Alert {} cleared", alert.id);
+                m_active.erase(it);
+                changed = true;
+            }
+            continue;
+        }
+        const auto raised = Clock::now();
+        const auto expires = ExpiresAt(alert.kind, raised);
+        if (it != m_active.end()) {
+            // Raised again, restart expiry and update payload
+            changed = changed || it->alert != alert;
+            *it = ActiveAlert{.alert = alert, .raised = raised, .expires = expires};
+            continue;
+        }
+        spdlog::info("Alert {} raised: {}", alert.id, alert.message);
+        m_active.push_back(ActiveAlert{.alert = alert, .raised = raised, .expires = expires});
+        changed = true;
+    }
+    if (changed) {
+        Changed();
+    }
+    Arm();
+    return changed;
+}
+
+void AlertSource::Clear() {
+    if (m_active.empty()) {
+        return;
+    }
+    spdlog::debug("Alerts acknowledged");
+    m_active.clear();
+    Changed();
+    Arm();
+}
+
+void AlertSource::Reconfigure(const AlertsConfig& config) {
+    m_config = config;
+    for (auto& active : m_active) {
+        active.expires = ExpiresAt(active.alert.kind, active.raised);
+    }
+    // Expired alerts are removed when the timer fires
+    Arm();
+}
+
+AlertSource::Clock::time_point AlertSource::ExpiresAt(AlertKind kind,
+                                                      Clock::time_point raised) const {
+    const auto timeout = m_config.TimeoutFor(kind);
+    return timeout > 0 ? raised + std::chrono::milliseconds(timeout) : Clock::time_point::max();
+}
+
+void AlertSource::Changed() {
+    // Highest priority first, stable to keep oldest first within same priority
+    std::stable_sort(m_active.begin(), m_active.end(), [](const auto& a, const auto& b) {
+        return a.alert.priority > b.alert.priority;
+    });
+    m_sourceState.clear();
+    for (const auto& active : m_active) {
+        m_sourceState.push_back(active.alert);
+    }
+    m_generation++;
+    m_drawn = m_published = false;
+}
+
+void AlertSource::Arm() {
+    auto next = Clock::time_point::max();
+    for (const auto& active : m_active) {
+        next = std::min(next, active.expires);
+    }
+    // Zero disarms timer
+    itimerspec timer = {};
+    if (next != Clock::time_point::max()) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(next - Clock::now());
+        ns = std::max(ns, std::chrono::nanoseconds(1));
+        timer.it_value.tv_sec = ns.count() / 1000000000;
+        timer.it_value.tv_nsec = ns.count() % 1000000000;
+    }
+    if (timerfd_settime(m_timerfd, 0, &timer, nullptr) == -1) {
+        spdlog::error("Failed to set alert timer: {}", strerror(errno));
+    }
+}
+
+bool AlertSource::OnRead() {
+    uint64_t ignore;
+    auto n = read(m_timerfd, &ignore, sizeof(ignore));
+    if (n <= 0) {
+        return false;
+    }
+    auto now = Clock::now();
+    auto expired = std::erase_if(m_active, [now](const auto& active) {
+        return active.expires <= now;
+    });
+    spdlog::debug("{} alerts expired", expired);
+    if (expired > 0) {
+        Changed();
+    }
+    Arm();
+    return expired > 0;
+}
+
+void AlertSource::Publish(const std::string_view sourceName, ScriptContext& scriptContext) {
+    if (m_published) return;
+    scriptContext.Publish(sourceName, m_sourceState);
+    m_published = true;
+}
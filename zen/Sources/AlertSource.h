@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+#include "zen/Configuration.h"
+#include "zen/MainLoop.h"
+#include "zen/ScriptContext.h"
+#include "zen/Sources/Sources.h"
+
+// Maintains the set of active alerts raised by other sources. Alerts are kept
+// in priority order until cleared by the raising source, acknowledged by the user
+// or expired.
+class AlertSource : public Source, public IoHandler {
+   public:
+    static std::shared_ptr<AlertSource> Create(std::shared_ptr<MainLoop> mainloop,
+                                               const AlertsConfig& config);
+    virtual ~AlertSource();
+    // Returns true if set of active alerts changed
+    bool Apply(const std::vector<AlertEvent>& events);
+    // Acknowledges all alerts
+    void Clear();
+    // Timeouts of reloaded configuration, also applied to active alerts
+    void Reconfigure(const AlertsConfig& config);
+    bool IsEmpty() const { return m_active.empty(); }
+    // Changes every time set of active alerts changes
+    uint64_t Generation() const { return m_generation; }
+
+    virtual bool OnRead() override;
+    void Publish(const std::string_view sourceName, ScriptContext& scriptContext) override;
+
+   private:
+    using Clock = std::chrono::steady_clock;
+    struct ActiveAlert {
+        Alert alert;
+        Clock::time_point raised;
+        Clock::time_point expires;
+    };
+
+    AlertSource(int fd, const AlertsConfig& config)
+        : Source(), m_timerfd(fd), m_config(config), m_generation(0) {}
+    void Changed();
+    void Arm();
+    Clock::time_point ExpiresAt(AlertKind kind, Clock::time_point raised) const;
+
+    int m_timerfd;
+    AlertsConfig m_config;
+    std::vector<ActiveAlert> m_active;
+    Alerts m_sourceState;
+    uint64_t m_generation;
+};
@@ -0,0 +1,28 @@
+#include "zen/Sources/FileSource.h"
+
+#include <spdlog/spdlog.h>
+
+#include "zen/FileCache.h"
+
+std::shared_ptr<FileSource> FileSource::Create() {
+    if (FileCache::Shared().Fd() == -1) {
+        return nullptr;
+    }
+    auto source = std::shared_ptr<FileSource>(new FileSource());
+    FileCache::Shared().SetOnChanged([weak = std::weak_ptr(source)]() {
+        if (auto source = weak.lock()) {
+            spdlog::debug("Files source is dirty");
+            source->m_changes++;
+            source->m_drawn = source->m_published = false;
+        }
+    });
+    return source;
+}
+
+void FileSource::Publish(const std::string_view sourceName, ScriptContext& scriptContext) {
+    if (m_published) return;
+    ScriptValue changes;
+    changes.scalar = m_changes;
+    scriptContext.Publish(sourceName, changes);
+    m_published = true;
+}
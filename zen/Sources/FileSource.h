@@ -0,0 +1,21 @@
+#pragma once
+
+#include <memory>
+
+#include "zen/ScriptContext.h"
+#include "zen/Sources/Sources.h"
+
+// Dirty when files read through zen.fs change. Publishes the number of changes so far, to
+// be used as a dependency of zen.cache. The file cache is invalidated by the main loop
+// whether or not this source is used.
+class FileSource : public Source {
+   public:
+    static std::shared_ptr<FileSource> Create();
+
+    void Publish(const std::string_view sourceName, ScriptContext& scriptContext) override;
+
+   private:
+    FileSource() : Source(), m_changes(0) {}
+
+    int64_t m_changes;
+};
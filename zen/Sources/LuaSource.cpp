@@ -0,0 +1,62 @@
+#include "zen/Sources/LuaSource.h"
+
+#include <spdlog/spdlog.h>
+
+std::shared_ptr<LuaSource> LuaSource::Create(std::shared_ptr<MainLoop> mainLoop,
+                                             const std::string& path, const std::string& name,
+                                             std::chrono::milliseconds interval) {
+    auto source = std::shared_ptr<LuaSource>(new LuaSource());
+    // Configuration is executed on the thread as well, it might take a while
+    source->m_thread =
+        std::thread(&LuaSource::Poll, source.get(), mainLoop, path, name, interval);
+    return source;
+}
+
+LuaSource::~LuaSource() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopped = true;
+    }
+    m_stopped.notify_one();
+    m_thread.join();
+}
+
+void LuaSource::Poll(std::shared_ptr<MainLoop> mainLoop, std::string path, std::string name,
+                     std::chrono::milliseconds interval) {
+    auto poller = SourcePoller::Create(path.c_str(), name);
+    if (!poller) {
+        spdlog::error("Failed to start source {}", name);
+        return;
+    }
+    spdlog::info("Polling source {} every {} ms", name, interval.count());
+    while (true) {
+        auto state = poller->Poll();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_isStopped) {
+            break;
+        }
+        if (state && state != m_sourceState) {
+            spdlog::debug("Source {} is dirty", name);
+            m_sourceState = std::move(*state);
+            m_isNew = true;
+            mainLoop->Wakeup();
+        }
+        if (m_stopped.wait_for(lock, interval, [this] { return m_isStopped; })) {
+            break;
+        }
+    }
+    spdlog::debug("Stopped polling source {}", name);
+}
+
+void LuaSource::Publish(const std::string_view sourceName, ScriptContext& scriptContext) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_isNew) {
+        // Dirty on the main thread, a state polled during a draw is drawn by the next one
+        m_isNew = false;
+        m_published = false;
+        m_drawn = false;
+    }
+    if (m_published || !m_sourceState) return;
+    scriptContext.Publish(sourceName, *m_sourceState);
+    m_published = true;
+}
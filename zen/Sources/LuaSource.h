@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "zen/MainLoop.h"
+#include "zen/ScriptContext.h"
+#include "zen/Sources/Sources.h"
+
+// Source defined in configuration by a poll function. Poll is called every interval on a
+// thread of its own, in a Lua state of its own, and the returned value is published when it
+// differs from the previous one. Nothing is published until the first poll has returned.
+// The polling thread only hands over the state, it is marked dirty when published.
+class LuaSource : public Source {
+   public:
+    static std::shared_ptr<LuaSource> Create(std::shared_ptr<MainLoop> mainLoop,
+                                             const std::string& path, const std::string& name,
+                                             std::chrono::milliseconds interval);
+    // Waits for the polling thread, a poll in progress is completed first
+    virtual ~LuaSource();
+
+    void Publish(const std::string_view sourceName, ScriptContext& scriptContext) override;
+
+   private:
+    LuaSource() : Source(), m_isStopped(false), m_isNew(false) {
+        // Not dirty until polled
+        m_drawn = true;
+    }
+    void Poll(std::shared_ptr<MainLoop> mainLoop, std::string path, std::string name,
+              std::chrono::milliseconds interval);
+
+    std::mutex m_mutex;
+    std::condition_variable m_stopped;
+    bool m_isStopped;                          // Guarded by mutex
+    std::optional<ScriptValue> m_sourceState;  // Guarded by mutex, empty until polled
+    bool m_isNew;                              // Guarded by mutex, polled since published
+    std::thread m_thread;
+};
@@ -68,7 +68,6 @@ void NetworkSource::ReadState() {
     }
     auto ifr = ifc.ifc_req;
     auto nInterfaces = ifc.ifc_len / sizeof(struct ifreq);
-    bool alerted = false;
     bool changed = false;
     // Note that only interfaces that are up is iterated here
     // so to detect interfaces that were up but now is down, clear
@@ -103,6 +102,9 @@ void NetworkSource::ReadState() {
             auto &existing = m_networks[item->ifr_name];
             if (existing != network) {
                 changed = true;
+                if (existing.isAlerted) {
+                    m_mainloop->ClearAlertAndWakeup(AlertKind::Network, item->ifr_name);
+                }
                 m_networks[item->ifr_name] = std::move(network);
             } else {
                 existing.isUp = true;
@@ -120,15 +122,15 @@ void NetworkSource::ReadState() {
         auto &network = keyValue.second;
         if (!network.isUp && !network.isAlerted) {
             network.isAlerted = true;
-            alerted = true;
             changed = true;
+            spdlog::info("Network source is triggering alert");
+            m_mainloop->AlertAndWakeup(Alert{.kind = AlertKind::Network,
+                                             .priority = AlertPriority::Normal,
+                                             .id = keyValue.first,
+                                             .message = "Network " + keyValue.first + " down"});
         }
     }
     m_drawn = m_published = !changed;
-    if (alerted) {
-        spdlog::info("Network source is triggering alert");
-        m_mainloop->AlertAndWakeup();
-    }
 }
 
 bool NetworkSource::OnRead() {
@@ -100,15 +100,21 @@ void PowerSource::ReadState() {
         spdlog::info("Power status changed, alert {}, capacity {}, charging {}, plugged in {}",
                      state.IsAlerted, state.Capacity, state.IsCharging, state.IsPluggedIn);
         // Alert state changed
-        if (state.IsAlerted != m_sourceState.IsAlerted) {
-            if (state.IsAlerted) {
-                // To alert
-                spdlog::info("Power source is triggering alert");
-                m_mainloop->AlertAndWakeup();
-            } else {
-                // From alert to non alert
-                // TODO:
-            }
+        auto priority = [](const PowerState& s) {
+            return s.Capacity < 10 ? AlertPriority::Critical : AlertPriority::High;
+        };
+        if (state.IsAlerted &&
+            (!m_sourceState.IsAlerted || priority(state) != priority(m_sourceState))) {
+            // To alert or escalated to critical
+            spdlog::info("Power source is triggering alert");
+            m_mainloop->AlertAndWakeup(
+                Alert{.kind = AlertKind::Power,
+                      .priority = priority(state),
+                      .id = "BAT0",
+                      .message = "Battery at " + std::to_string(state.Capacity) + "%"});
+        } else if (!state.IsAlerted && m_sourceState.IsAlerted) {
+            // From alert to non alert
+            m_mainloop->ClearAlertAndWakeup(AlertKind::Power, "BAT0");
         }
         m_sourceState = state;
         m_drawn = m_published = false;
@@ -153,6 +153,11 @@ void PulseAudioSource::OnSinkChange(const pa_sink_info* info) {
 }
 
 // This is invoked on main thread. Can not publish on another thread
+void PulseAudioSource::ClearPublished() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_published = false;
+}
+
 void PulseAudioSource::Publish(const std::string_view sourceName, ScriptContext& scriptContext) {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_published) return;
@@ -21,6 +21,7 @@ class PulseAudioSource : public Source {
     void OnServerChange(const pa_server_info*);
     void OnSinkChange(const pa_sink_info*);
     void Publish(const std::string_view sourceName, ScriptContext& scriptContext) override;
+    void ClearPublished() override;
 
    private:
     PulseAudioSource(std::shared_ptr<MainLoop> mainloop, pa_threaded_mainloop* mainLoop,
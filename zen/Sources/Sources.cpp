@@ -32,6 +32,14 @@ void Sources::ForceRedraw() {
     }
 }
 
+void Sources::SetScriptContext(std::unique_ptr<ScriptContext> scriptContext) {
+    m_scriptContext = std::move(scriptContext);
+    for (auto const& source : m_sources) {
+        source.second->ClearPublished();
+        source.second->ClearDrawn();
+    }
+}
+
 void Sources::PublishAll() {
     for (auto const& source : m_sources) {
         source.second->Publish(source.first, *m_scriptContext);
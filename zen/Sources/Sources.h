@@ -13,6 +13,8 @@ class Source {
     void SetDrawn() { m_drawn = true; }
     void ClearDrawn() { m_drawn = false; }
     bool IsDrawn() { return m_drawn; }
+    // State is published again on next publish, like to a new script context
+    virtual void ClearPublished() { m_published = false; }
 
     virtual void Publish(const std::string_view sourceName, ScriptContext& scriptContext) = 0;
     virtual ~Source() {}
@@ -32,6 +34,13 @@ class Sources {
     void ForceRedraw();
     bool NeedsRedraw(const std::set<std::string> sources) const;
     void PublishAll();
+    // Replaces the script context when configuration is reloaded, the previous one is
+    // destroyed. All sources are published to the new one on next publish.
+    void SetScriptContext(std::unique_ptr<ScriptContext> scriptContext);
+    // Returns true if there is more garbage to collect
+    bool CollectGarbage(std::chrono::microseconds budget) {
+        return m_scriptContext->CollectGarbage(budget);
+    }
 
    private:
     Sources(std::unique_ptr<ScriptContext> scriptContext)
@@ -0,0 +1,74 @@
+#include "zen/Sources/StatsSource.h"
+
+#include <signal.h>
+#include <spdlog/spdlog.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cstring>
+
+std::shared_ptr<StatsSource> StatsSource::Create(std::shared_ptr<MainLoop> mainloop,
+                                                 bool isPublishing) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    auto signalfd = ::signalfd(-1, &mask, SFD_CLOEXEC | SFD_NONBLOCK);
+    if (signalfd == -1) {
+        spdlog::error("Failed to create signal fd: {}", strerror(errno));
+        return nullptr;
+    }
+    auto source = std::shared_ptr<StatsSource>(new StatsSource(signalfd, -1));
+    mainloop->RegisterIoHandler(signalfd, "StatsSource", source);
+    if (isPublishing && !source->StartPublishing(*mainloop)) {
+        return nullptr;
+    }
+    return source;
+}
+
+bool StatsSource::StartPublishing(MainLoop& mainloop) {
+    if (m_timerfd != -1) {
+        return true;
+    }
+    auto timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    itimerspec timer = {.it_interval = {.tv_sec = 1, .tv_nsec = 0},
+                        .it_value = {.tv_sec = 1, .tv_nsec = 0}};
+    if (timerfd == -1 || timerfd_settime(timerfd, 0, &timer, nullptr) == -1) {
+        spdlog::error("Failed to create stats timer: {}", strerror(errno));
+        if (timerfd != -1) close(timerfd);
+        return false;
+    }
+    m_timerfd = timerfd;
+    mainloop.RegisterIoHandler(m_timerfd, "StatsSource", shared_from_this());
+    return true;
+}
+
+StatsSource::~StatsSource() {
+    close(m_signalfd);
+    if (m_timerfd != -1) close(m_timerfd);
+}
+
+bool StatsSource::OnRead() {
+    // Registered for both, either might be ready
+    signalfd_siginfo info;
+    while (read(m_signalfd, &info, sizeof(info)) == sizeof(info)) {
+        ScriptStats::Shared().Log();
+    }
+    uint64_t ignore;
+    if (m_timerfd == -1 || read(m_timerfd, &ignore, sizeof(ignore)) <= 0) {
+        return false;
+    }
+    auto snapshot = ScriptStats::Shared().Snapshot();
+    if (snapshot == m_sourceState) {
+        return false;
+    }
+    m_sourceState = std::move(snapshot);
+    m_drawn = m_published = false;
+    return true;
+}
+
+void StatsSource::Publish(const std::string_view sourceName, ScriptContext& scriptContext) {
+    if (m_published) return;
+    scriptContext.Publish(sourceName, m_sourceState);
+    m_published = true;
+}
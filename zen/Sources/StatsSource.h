@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+
+#include "zen/MainLoop.h"
+#include "zen/ScriptContext.h"
+#include "zen/Sources/Sources.h"
+
+// Publishes the cost of Lua callbacks as zen.stats once a second when publishing and
+// logs them when the process receives SIGUSR1. SIGUSR1 must be blocked in all threads
+// before creating the source.
+class StatsSource : public Source,
+                    public IoHandler,
+                    public std::enable_shared_from_this<StatsSource> {
+   public:
+    static std::shared_ptr<StatsSource> Create(std::shared_ptr<MainLoop> mainloop,
+                                               bool isPublishing);
+    virtual ~StatsSource();
+    // Publishes from now on, when first used by a reloaded configuration
+    bool StartPublishing(MainLoop& mainloop);
+
+    virtual bool OnRead() override;
+    void Publish(const std::string_view sourceName, ScriptContext& scriptContext) override;
+
+   private:
+    StatsSource(int signalfd, int timerfd)
+        : Source(), m_signalfd(signalfd), m_timerfd(timerfd) {}
+
+    int m_signalfd;
+    int m_timerfd;  // -1 when not publishing
+    std::vector<CallStats> m_sourceState;
+};
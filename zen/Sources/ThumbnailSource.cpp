@@ -0,0 +1,81 @@
+#include "zen/Sources/ThumbnailSource.h"
+
+#include <spdlog/spdlog.h>
+
+std::shared_ptr<ThumbnailSource> ThumbnailSource::Create(std::shared_ptr<MainLoop> mainloop,
+                                                         std::shared_ptr<FrameProducer> producer) {
+    return std::shared_ptr<ThumbnailSource>(new ThumbnailSource(mainloop, producer));
+}
+
+void ThumbnailSource::Update(const Displays& displays) {
+    std::set<std::pair<std::string, std::string>> existing;
+    for (const auto& display : displays) {
+        for (const auto& workspace : display.workspaces) {
+            existing.emplace(display.name, workspace.name);
+            if (workspace.isVisible) {
+                m_visible[display.name] = workspace.name;
+                m_stale.insert(display.name);
+            }
+        }
+    }
+    // Forget workspaces that has been removed
+    ThumbnailCache::Shared().Retain([&existing](const auto& outputName, const auto& workspaceName) {
+        return existing.contains({outputName, workspaceName});
+    });
+    // The overlay would be part of the capture, wait until hidden
+    if (!m_isVisible) {
+        CaptureStale();
+    }
+}
+
+void ThumbnailSource::SetVisible(bool isVisible) {
+    m_isVisible = isVisible;
+    if (isVisible) {
+        // Shows the frames captured while hidden, captures in flight would include the overlay
+        m_shown++;
+        return;
+    }
+    // Invoked after the overlay is hidden, keep what was below it until shown again
+    for (const auto& keyValue : m_visible) {
+        m_stale.insert(keyValue.first);
+    }
+    CaptureStale();
+}
+
+void ThumbnailSource::CaptureStale() {
+    for (const auto& outputName : m_stale) {
+        auto it = m_visible.find(outputName);
+        if (it != m_visible.end()) {
+            Capture(outputName, it->second);
+        }
+    }
+    m_stale.clear();
+}
+
+void ThumbnailSource::Capture(const std::string& outputName, const std::string& workspaceName) {
+    if (m_pending.contains(outputName)) {
+        spdlog::trace("Capture of {} already in flight", outputName);
+        return;
+    }
+    spdlog::debug("Capturing {} on {}", workspaceName, outputName);
+    m_pending.insert(outputName);
+    std::weak_ptr<ThumbnailSource> weak = shared_from_this();
+    auto started = m_producer->Capture(
+        outputName, [weak, outputName, workspaceName, shown = m_shown](const Frame& frame) {
+            auto self = weak.lock();
+            if (!self) return;
+            self->m_pending.erase(outputName);
+            if (!frame.pixels) return;
+            if (self->m_isVisible || self->m_shown != shown) {
+                spdlog::debug("Dropping capture of {} made while overlay was shown", outputName);
+                return;
+            }
+            ThumbnailCache::Shared().Store(outputName, workspaceName, frame);
+            self->m_drawn = false;
+            // Captures completes when reading wayland events which never dirties anything
+            self->m_mainloop->Wakeup();
+        });
+    if (!started) {
+        m_pending.erase(outputName);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+
+#include "zen/MainLoop.h"
+#include "zen/Sources/Sources.h"
+#include "zen/ThumbnailCache.h"
+
+// Captures the visible workspace of every display into the thumbnail cache. Captures are
+// only made when the overlay is hidden or when the compositor reports a change while
+// hidden, never per frame, so that the overlay is never part of a thumbnail. Nodes looks
+// up the thumbnails directly in the cache, nothing is published to Lua.
+class ThumbnailSource : public Source, public std::enable_shared_from_this<ThumbnailSource> {
+   public:
+    static std::shared_ptr<ThumbnailSource> Create(std::shared_ptr<MainLoop> mainloop,
+                                                   std::shared_ptr<FrameProducer> producer);
+    virtual ~ThumbnailSource() {}
+    // Compositor reported a change
+    void Update(const Displays& displays);
+    void SetVisible(bool isVisible);
+
+    void Publish(const std::string_view, ScriptContext&) override {}
+
+   private:
+    ThumbnailSource(std::shared_ptr<MainLoop> mainloop, std::shared_ptr<FrameProducer> producer)
+        : Source(), m_mainloop(mainloop), m_producer(producer), m_isVisible(false), m_shown(0) {}
+    void Capture(const std::string& outputName, const std::string& workspaceName);
+    void CaptureStale();
+
+    std::shared_ptr<MainLoop> m_mainloop;
+    std::shared_ptr<FrameProducer> m_producer;
+    bool m_isVisible;
+    int m_shown;                                   // Times the overlay has been shown
+    std::map<std::string, std::string> m_visible;  // Visible workspace per output
+    std::set<std::string> m_stale;                 // Outputs to capture when possible
+    std::set<std::string> m_pending;               // Outputs with capture in flight
+};
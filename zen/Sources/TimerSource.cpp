@@ -0,0 +1,15 @@
+#include "zen/Sources/TimerSource.h"
+
+#include <spdlog/spdlog.h>
+
+std::shared_ptr<TimerSource> TimerSource::Create(std::shared_ptr<Timers> timers) {
+    auto source = std::shared_ptr<TimerSource>(new TimerSource());
+    timers->SetOnRun([weak = std::weak_ptr(source)]() {
+        if (auto source = weak.lock()) {
+            spdlog::debug("Timer source set to dirty");
+            source->m_published = true;  // No need to publish
+            source->m_drawn = false;
+        }
+    });
+    return source;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <memory>
+
+#include "zen/ScriptContext.h"
+#include "zen/Sources/Sources.h"
+#include "zen/Timers.h"
+
+// Dirty when timers have run, for widgets showing state updated by zen.every and zen.after
+class TimerSource : public Source {
+   public:
+    static std::shared_ptr<TimerSource> Create(std::shared_ptr<Timers> timers);
+    void Publish(const std::string_view, ScriptContext&) override {}
+
+   private:
+    TimerSource() : Source() {}
+};
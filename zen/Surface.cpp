@@ -0,0 +1,51 @@
+#include "zen/Surface.h"
+
+#include <spdlog/spdlog.h>
+
+// Finds the widget and the tag of the innermost target at position
+static const WidgetConfig *Hit(const PanelConfig &panelConfig, const DrawnPanel &drawn, int x,
+                               int y, std::string &tag) {
+    int i = 0;
+    for (const auto &w : drawn.widgets) {
+        if (w.position.Contains(x, y)) {
+            for (const auto &t : w.targets) {
+                if (t.position.Contains(x, y)) {
+                    tag = t.tag;
+                    break;
+                }
+            }
+            return &panelConfig.widgets.at(i);
+        }
+        i++;
+    }
+    return nullptr;
+}
+
+void Surface::Reconfigure(PanelConfig panelConfig) {
+    m_panelConfig = std::move(panelConfig);
+    // Widgets might have moved, no targets until drawn again
+    m_drawn.rendered.clear();
+    m_drawn.widgets.clear();
+}
+
+bool Surface::Click(int x, int y) {
+    std::string tag = "";
+    auto widget = Hit(m_panelConfig, m_drawn, x, y, tag);
+    if (!widget || !widget->click) {
+        return false;
+    }
+    spdlog::debug("Click in widget, tag: {}", tag);
+    widget->click(tag);
+    return true;
+}
+
+bool Surface::Wheel(int x, int y, int value) {
+    std::string tag = "";
+    auto widget = Hit(m_panelConfig, m_drawn, x, y, tag);
+    if (!widget || !widget->wheel) {
+        return false;
+    }
+    spdlog::debug("Wheel in widget, tag: {}", tag);
+    widget->wheel(tag, value);
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zen/Buffer.h"
+#include "zen/Configuration.h"
+#include "zen/Draw.h"
+
+// A surface that a single panel is drawn on. Implemented by ShellSurface for a
+// real compositor and by HeadlessSurface when rendering into memory.
+class Surface {
+   public:
+    virtual ~Surface() {}
+    // Widgets not flagged in dirtyWidgets are reused from last draw, empty means all dirty
+    virtual void Draw(BufferPool &bufferPool, const std::string &outputName,
+                      const std::vector<bool> &dirtyWidgets) = 0;
+    virtual void Hide() = 0;
+
+    // Dispatches pointer events to the widget at position, returns true if a handler was
+    // invoked.
+    bool Click(int x, int y);
+    bool Wheel(int x, int y, int value);
+
+    const DrawnPanel &Drawn() const { return m_drawn; }
+    // Used by next draw instead of rendering those widgets again
+    void SetPrerendered(std::vector<std::unique_ptr<Renderable>> prerendered) {
+        m_drawn.prerendered = std::move(prerendered);
+    }
+    // Sources changed without the panel being drawn, all widgets are rendered on next draw
+    void Invalidate() { m_drawn.rendered.clear(); }
+    // Panel configuration of a reloaded configuration, all widgets are rendered on next draw
+    void Reconfigure(PanelConfig panelConfig);
+
+   protected:
+    Surface(PanelConfig panelConfig) : m_panelConfig(std::move(panelConfig)) {}
+
+    PanelConfig m_panelConfig;
+    DrawnPanel m_drawn;
+};
@@ -0,0 +1,141 @@
+#include "zen/Template.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+void BoundValues::Set(std::string_view path, BoundValue value) {
+    auto it = m_values.find(path);
+    if (it == m_values.end()) {
+        m_values.emplace(std::string(path), Entry{.value = std::move(value), .version = 1});
+        return;
+    }
+    if (it->second.value != value) {
+        it->second.value = std::move(value);
+        it->second.version++;
+    }
+}
+
+const BoundValue& BoundValues::Get(std::string_view path) const {
+    static const BoundValue missing;
+    auto it = m_values.find(path);
+    return it != m_values.end() ? it->second.value : missing;
+}
+
+uint64_t BoundValues::Version(std::string_view path) const {
+    auto it = m_values.find(path);
+    return it != m_values.end() ? it->second.version : 0;
+}
+
+std::string ToString(const BoundValue& value) {
+    if (auto b = std::get_if<bool>(&value)) {
+        return *b ? "true" : "false";
+    }
+    if (auto d = std::get_if<double>(&value)) {
+        return fmt::format("{}", *d);
+    }
+    if (auto s = std::get_if<std::string>(&value)) {
+        return *s;
+    }
+    return "";
+}
+
+Expression Expressions::Literal(BoundValue value) {
+    return [value = std::move(value)](const BoundValues&) { return value; };
+}
+
+Expression Expressions::Bind(std::string path) {
+    return [path = std::move(path)](const BoundValues& values) { return values.Get(path); };
+}
+
+// Formats a single placeholder with its spec
+static std::string FormatValue(const std::string& spec, const BoundValue& value) {
+    try {
+        if (auto b = std::get_if<bool>(&value)) {
+            return fmt::format(fmt::runtime(spec), *b);
+        }
+        if (auto d = std::get_if<double>(&value)) {
+            return fmt::format(fmt::runtime(spec), *d);
+        }
+        if (auto s = std::get_if<std::string>(&value)) {
+            return fmt::format(fmt::runtime(spec), *s);
+        }
+    } catch (const fmt::format_error& e) {
+        spdlog::error("Failed to format {} in template: {}", spec, e.what());
+    }
+    return "";
+}
+
+Expression Expressions::Format(const std::string& format, std::vector<Expression> args) {
+    // Split once into literal text and placeholder specs, {{ and }} are escapes
+    std::vector<std::string> texts(1);
+    std::vector<std::string> specs;
+    for (size_t i = 0; i < format.size(); i++) {
+        const auto c = format[i];
+        if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c) {
+            texts.back() += c;
+            i++;
+            continue;
+        }
+        if (c == '}') {
+            spdlog::error("Unmatched }} in template format: {}", format);
+            return nullptr;
+        }
+        if (c != '{') {
+            texts.back() += c;
+            continue;
+        }
+        auto end = format.find('}', i);
+        if (end == std::string::npos) {
+            spdlog::error("Unmatched {{ in template format: {}", format);
+            return nullptr;
+        }
+        specs.push_back(format.substr(i, end - i + 1));
+        texts.emplace_back();
+        i = end;
+    }
+    if (specs.size() != args.size()) {
+        spdlog::error("Template format {} expects {} arguments, got {}", format, specs.size(),
+                      args.size());
+        return nullptr;
+    }
+    return [texts = std::move(texts), specs = std::move(specs),
+            args = std::move(args)](const BoundValues& values) -> BoundValue {
+        auto result = texts[0];
+        for (size_t i = 0; i < specs.size(); i++) {
+            result += FormatValue(specs[i], args[i](values));
+            result += texts[i + 1];
+        }
+        return result;
+    };
+}
+
+Expression Expressions::Levels(Expression input, std::vector<std::pair<double, Expression>> levels,
+                               Expression otherwise) {
+    std::stable_sort(levels.begin(), levels.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    return [input = std::move(input), levels = std::move(levels),
+            otherwise = std::move(otherwise)](const BoundValues& values) -> BoundValue {
+        const auto value = input(values);
+        if (auto d = std::get_if<double>(&value)) {
+            for (const auto& level : levels) {
+                if (*d <= level.first) {
+                    return level.second(values);
+                }
+            }
+        }
+        return otherwise ? otherwise(values) : BoundValue();
+    };
+}
+
+Expression Expressions::Map(Expression input, std::map<std::string, Expression> cases,
+                            Expression otherwise) {
+    return [input = std::move(input), cases = std::move(cases),
+            otherwise = std::move(otherwise)](const BoundValues& values) -> BoundValue {
+        auto it = cases.find(ToString(input(values)));
+        if (it != cases.end()) {
+            return it->second(values);
+        }
+        return otherwise ? otherwise(values) : BoundValue();
+    };
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// Value of a source field that templates can bind to, like power.capacity. Monostate when
+// the source has not been published.
+using BoundValue = std::variant<std::monostate, bool, double, std::string>;
+
+class BoundValues {
+   public:
+    void Set(std::string_view path, BoundValue value);
+    const BoundValue& Get(std::string_view path) const;
+    // Increased each time the value changes, 0 when never set
+    uint64_t Version(std::string_view path) const;
+
+   private:
+    struct Entry {
+        BoundValue value;
+        uint64_t version;
+    };
+    std::map<std::string, Entry, std::less<>> m_values;
+};
+
+std::string ToString(const BoundValue& value);
+
+// Part of a template evaluated natively from bound values without calling Lua
+using Expression = std::function<BoundValue(const BoundValues& values)>;
+
+namespace Expressions {
+Expression Literal(BoundValue value);
+Expression Bind(std::string path);
+// Format with {} placeholders taking fmt format specs, like {:.0f}. Returns nullptr if the
+// format is invalid.
+Expression Format(const std::string& format, std::vector<Expression> args);
+// First level where input is less than or equal to the threshold, otherwise if none is
+// or input is not a number.
+Expression Levels(Expression input, std::vector<std::pair<double, Expression>> levels,
+                  Expression otherwise);
+// Case matching input converted to string
+Expression Map(Expression input, std::map<std::string, Expression> cases, Expression otherwise);
+}  // namespace Expressions
@@ -0,0 +1,58 @@
+#include "zen/ThumbnailCache.h"
+
+#include <spdlog/spdlog.h>
+
+#include "zen/Downscale.h"
+
+// Max width of stored thumbnails, nodes scales them further when painting
+static constexpr int MAX_WIDTH = 480;
+
+ThumbnailCache& ThumbnailCache::Shared() {
+    static ThumbnailCache cache;
+    return cache;
+}
+
+void ThumbnailCache::Store(const std::string& outputName, const std::string& workspaceName,
+                           const Frame& frame) {
+    // Smallest integer factor that fits the width, box filter needs integer factors
+    const int factor = std::max(1, (frame.cx + MAX_WIDTH - 1) / MAX_WIDTH);
+    const int cx = frame.cx / factor;
+    const int cy = frame.cy / factor;
+    if (cx <= 0 || cy <= 0) {
+        spdlog::error("Frame of {} too small for thumbnail: {}x{}", outputName, frame.cx,
+                      frame.cy);
+        return;
+    }
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, cx, cy);
+    auto data = cairo_image_surface_get_data(surface);
+    const int stride = cairo_image_surface_get_stride(surface);
+    cairo_surface_flush(surface);
+    BoxDownscale(frame.pixels, frame.cx, frame.cy, frame.stride, factor, data, stride);
+    if (!frame.hasAlpha) {
+        // Make opaque, alpha is the most significant byte of native endian ARGB32
+        for (int y = 0; y < cy; y++) {
+            auto row = (uint32_t*)(data + y * stride);
+            for (int x = 0; x < cx; x++) {
+                row[x] |= 0xff000000;
+            }
+        }
+    }
+    cairo_surface_mark_dirty(surface);
+    spdlog::debug("Thumbnail of {} on {}: {}x{} from {}x{}", workspaceName, outputName, cx, cy,
+                  frame.cx, frame.cy);
+    m_entries[Key(outputName, workspaceName)] = std::make_shared<ThumbnailImage>(surface, cx, cy);
+}
+
+std::shared_ptr<const ThumbnailImage> ThumbnailCache::Lookup(
+    const std::string& outputName, const std::string& workspaceName) const {
+    auto it = m_entries.find(Key(outputName, workspaceName));
+    return it != m_entries.end() ? it->second : nullptr;
+}
+
+void ThumbnailCache::Retain(
+    const std::function<bool(const std::string& outputName, const std::string& workspaceName)>&
+        keep) {
+    std::erase_if(m_entries, [&keep](const auto& keyValue) {
+        return !keep(keyValue.first.first, keyValue.first.second);
+    });
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cairo.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+// Captured frame of an output, 32 bits per pixel. Stride is negative for bottom up frames.
+struct Frame {
+    const uint8_t* pixels;
+    int cx;
+    int cy;
+    ptrdiff_t stride;
+    bool hasAlpha;  // XRGB frames has undefined alpha
+};
+
+// Produces frames of outputs, implemented by screencopy and by fakes in tests
+class FrameProducer {
+   public:
+    using OnFrame = std::function<void(const Frame& frame)>;
+    virtual ~FrameProducer() {}
+    // Captures next frame of output. The frame is only valid during the callback, it might be
+    // called directly or at a later point. Pixels are null if the capture failed. Returns false
+    // if capture could not be started.
+    virtual bool Capture(const std::string& outputName, OnFrame onFrame) = 0;
+};
+
+// Downscaled capture ready to be painted
+struct ThumbnailImage {
+    ThumbnailImage(cairo_surface_t* surface_, int cx_, int cy_)
+        : surface(surface_), cx(cx_), cy(cy_) {}
+    ~ThumbnailImage() { cairo_surface_destroy(surface); }
+    ThumbnailImage(const ThumbnailImage&) = delete;
+    ThumbnailImage& operator=(const ThumbnailImage&) = delete;
+
+    cairo_surface_t* surface;
+    int cx;
+    int cy;
+};
+
+// Keeps the latest downscaled capture of every workspace that has been visible on an output
+class ThumbnailCache {
+   public:
+    static ThumbnailCache& Shared();
+
+    // Downscales frame and stores it
+    void Store(const std::string& outputName, const std::string& workspaceName,
+               const Frame& frame);
+    std::shared_ptr<const ThumbnailImage> Lookup(const std::string& outputName,
+                                                 const std::string& workspaceName) const;
+    // Drops thumbnails of workspaces that no longer exists
+    void Retain(const std::function<bool(const std::string& outputName,
+                                         const std::string& workspaceName)>& keep);
+    void Clear() { m_entries.clear(); }
+
+   private:
+    using Key = std::pair<std::string, std::string>;
+    ThumbnailCache() {}
+
+    std::map<Key, std::shared_ptr<const ThumbnailImage>> m_entries;
+};
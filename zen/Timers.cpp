@@ -0,0 +1,114 @@
+#include "zen/Timers.h"
+
+#include <spdlog/spdlog.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <vector>
+
+std::shared_ptr<Timers> Timers::Create(std::shared_ptr<MainLoop> mainLoop) {
+    auto fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd == -1) {
+        spdlog::error("Failed to create timer: {}", strerror(errno));
+        return nullptr;
+    }
+    auto timers = std::shared_ptr<Timers>(new Timers(fd));
+    mainLoop->RegisterIoHandler(fd, "Timers", timers);
+    return timers;
+}
+
+Timers::~Timers() { close(m_fd); }
+
+uint64_t Timers::Start(std::chrono::milliseconds delay, std::chrono::milliseconds interval,
+                       bool isAlways, OnTimer onTimer) {
+    const auto period = interval.count() > 0 ? interval : delay;
+    const auto id = m_nextId++;
+    m_timers[id] = Timer{.due = Clock::now() + delay,
+                         .slack = std::min(period / 10, MAX_SLACK),
+                         .interval = interval,
+                         .isAlways = isAlways,
+                         .onTimer = std::move(onTimer)};
+    Arm();
+    return id;
+}
+
+void Timers::Cancel(uint64_t id) {
+    if (m_timers.erase(id) > 0) {
+        Arm();
+    }
+}
+
+void Timers::SetVisible(bool isVisible) {
+    m_isVisible = isVisible;
+    Arm();
+}
+
+void Timers::Arm() {
+    // Steady clock is the monotonic clock
+    auto wakeup = Clock::time_point::max();
+    for (const auto& keyValue : m_timers) {
+        if (IsRunning(keyValue.second)) {
+            wakeup = std::min(wakeup, keyValue.second.due + keyValue.second.slack);
+        }
+    }
+    itimerspec timer{};
+    if (wakeup != Clock::time_point::max()) {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            wakeup.time_since_epoch())
+                            .count();
+        // Zero disarms
+        timer.it_value = {.tv_sec = ns / 1000000000, .tv_nsec = std::max(ns % 1000000000, 1L)};
+    }
+    if (timerfd_settime(m_fd, TFD_TIMER_ABSTIME, &timer, nullptr) == -1) {
+        spdlog::error("Failed to set timer: {}", strerror(errno));
+    }
+}
+
+bool Timers::OnRead() {
+    uint64_t ignore;
+    auto n = read(m_fd, &ignore, sizeof(ignore));
+    if (n <= 0) {
+        // Not expired, like after being armed again
+        return false;
+    }
+    // Timers might be started and cancelled by the timers being run
+    const auto now = Clock::now();
+    std::vector<uint64_t> due;
+    for (const auto& keyValue : m_timers) {
+        if (IsRunning(keyValue.second) && keyValue.second.due <= now) {
+            due.push_back(keyValue.first);
+        }
+    }
+    for (auto id : due) {
+        auto it = m_timers.find(id);
+        if (it == m_timers.end()) {
+            continue;
+        }
+        auto onTimer = it->second.onTimer;
+        const bool isRunning = onTimer();
+        it = m_timers.find(id);
+        if (it == m_timers.end()) {
+            continue;
+        }
+        auto& timer = it->second;
+        if (!isRunning || timer.interval.count() == 0) {
+            m_timers.erase(it);
+            continue;
+        }
+        // Keeps the phase unless behind, like after being suspended
+        timer.due += timer.interval;
+        if (timer.due <= now) {
+            timer.due = now + timer.interval;
+        }
+    }
+    Arm();
+    if (due.empty()) {
+        return false;
+    }
+    spdlog::trace("{} timers run", due.size());
+    if (m_onRun) {
+        m_onRun();
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+
+#include "zen/MainLoop.h"
+
+// Timers run on the main loop sharing one timerfd. A timer might run late by a slack of a
+// tenth of its period, so that timers due close to each other run in the same wakeup. Timers
+// that are not always running are suspended while the overlay is hidden, those that became
+// due meanwhile run once when it is shown again.
+class Timers : public IoHandler {
+   public:
+    // Returns false to stop the timer
+    using OnTimer = std::function<bool()>;
+    static std::shared_ptr<Timers> Create(std::shared_ptr<MainLoop> mainLoop);
+    virtual ~Timers();
+
+    // Runs onTimer after delay, and then every interval unless zero. Returns id to cancel
+    // the timer with, ids are never 0. Safe to call from timers.
+    uint64_t Start(std::chrono::milliseconds delay, std::chrono::milliseconds interval,
+                   bool isAlways, OnTimer onTimer);
+    void Cancel(uint64_t id);
+    // Hidden until set visible
+    void SetVisible(bool isVisible);
+    // Invoked when any timer has run, after all timers due
+    void SetOnRun(std::function<void()> onRun) { m_onRun = std::move(onRun); }
+    bool OnRead() override;
+
+   private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::chrono::milliseconds MAX_SLACK{100};
+    struct Timer {
+        Clock::time_point due;
+        Clock::duration slack;
+        std::chrono::milliseconds interval;
+        bool isAlways;
+        OnTimer onTimer;
+    };
+
+    Timers(int fd) : m_fd(fd), m_isVisible(false), m_nextId(1) {}
+    bool IsRunning(const Timer& timer) const { return timer.isAlways || m_isVisible; }
+    // Wakes up when the first running timer is due, or never
+    void Arm();
+
+    int m_fd;
+    bool m_isVisible;
+    uint64_t m_nextId;
+    std::map<uint64_t, Timer> m_timers;
+    std::function<void()> m_onRun;
+};
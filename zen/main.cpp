@@ -1,18 +1,30 @@
 #include <spdlog/cfg/env.h>
 #include <spdlog/spdlog.h>
 
+#include <signal.h>
+
 #include <filesystem>
 #include <optional>
 
 #include "zen/Compositors/Sway/SwayCompositor.h"
+#include "zen/ConfigWatcher.h"
+#include "zen/FileCache.h"
 #include "zen/MainLoop.h"
 #include "zen/Manager.h"
 #include "zen/Registry.h"
+#include "zen/Screencopy.h"
+#include "zen/Sources/AlertSource.h"
 #include "zen/Sources/DateTimeSources.h"
+#include "zen/Sources/FileSource.h"
+#include "zen/Sources/LuaSource.h"
 #include "zen/Sources/NetworkSource.h"
 #include "zen/Sources/PowerSource.h"
 #include "zen/Sources/PulseAudio/PulseAudioSource.h"
 #include "zen/Sources/Sources.h"
+#include "zen/Sources/StatsSource.h"
+#include "zen/Sources/ThumbnailSource.h"
+#include "zen/Sources/TimerSource.h"
+#include "zen/Timers.h"
 
 static const std::optional<std::filesystem::path> ProbeForConfig(int argc, char* argv[]) {
     // Explicit config
@@ -42,8 +54,15 @@ static const std::optional<std::filesystem::path> ProbeForConfig(int argc, char*
 }
 
 static void InitializeSource(const std::string& source, Sources& sources,
-                             std::shared_ptr<MainLoop> mainLoop, const Registry& registry,
-                             const Configuration config) {
+                             std::shared_ptr<MainLoop> mainLoop, std::shared_ptr<Timers> timers,
+                             const Registry& registry, const Configuration config) {
+    // Defined in configuration, polled in Lua
+    auto luaSource = config.luaSources.find(source);
+    if (luaSource != config.luaSources.end()) {
+        sources.Register(source, LuaSource::Create(mainLoop, config.files.front(), source,
+                                                   luaSource->second));
+        return;
+    }
     if (source == "date" || source == "time") {
         //  Date time sources
         auto dateSource = DateSource::Create();
@@ -52,10 +71,24 @@ static void InitializeSource(const std::string& source, Sources& sources,
         sources.Register("time", timeSource);
         return;
     }
-    if (source == "displays") {
+    if (source == "displays" || source == "alerts" || source == "thumbnails" ||
+        source == "stats") {
         // Initialized by manager later..
         return;
     }
+    if (source == "timers") {
+        sources.Register(source, TimerSource::Create(timers));
+        return;
+    }
+    if (source == "files") {
+        auto fileSource = FileSource::Create();
+        if (!fileSource) {
+            spdlog::error("Failed to initialize files source");
+            return;
+        }
+        sources.Register(source, fileSource);
+        return;
+    }
     if (source == "networks") {
         auto networkSource = NetworkSource::Create(mainLoop);
         if (!networkSource) {
@@ -104,9 +137,70 @@ static void InitializeSource(const std::string& source, Sources& sources,
     spdlog::error("Unknown source: {}", source);
 }
 
+// Sources hooked into the compositor and signal handling by main, started by the first
+// configuration using them
+struct HookedSources {
+    std::shared_ptr<ThumbnailSource> thumbnails;
+    std::shared_ptr<StatsSource> stats;  // Always logs on SIGUSR1, only published when used
+};
+
+static void InitializeHookedSource(const std::string& source, Sources& sources,
+                                   std::shared_ptr<MainLoop> mainLoop, const Registry& registry,
+                                   HookedSources& hooked) {
+    if (source == "thumbnails" && !hooked.thumbnails) {
+        // Thumbnails are captured from the compositor
+        auto screencopy = Screencopy::Create(registry);
+        if (!screencopy) {
+            spdlog::error("Failed to initialize thumbnails source");
+            return;
+        }
+        hooked.thumbnails = ThumbnailSource::Create(mainLoop, screencopy);
+        sources.Register(source, hooked.thumbnails);
+        return;
+    }
+    if (source == "stats" && hooked.stats && hooked.stats->StartPublishing(*mainLoop)) {
+        sources.Register(source, hooked.stats);
+    }
+}
+
+// Executes configuration in a new script context and replaces the running one. Returns the
+// files of the new configuration, empty if it failed and the running one is kept.
+static std::vector<std::string> Reload(const std::filesystem::path& path,
+                                       std::shared_ptr<MainLoop> mainLoop,
+                                       std::shared_ptr<Timers> timers,
+                                       std::shared_ptr<Registry> registry,
+                                       std::shared_ptr<Manager> manager,
+                                       std::shared_ptr<HookedSources> hooked) {
+    spdlog::info("Reloading configuration at: {}", path.c_str());
+    auto scriptContext = ScriptContext::Create();
+    if (!scriptContext) {
+        spdlog::error("Failed to create script context");
+        return {};
+    }
+    scriptContext->Attach(mainLoop, timers);
+    const auto config = scriptContext->Execute(path.c_str());
+    if (!config) {
+        spdlog::error("Failed to reload configuration, keeping the running one");
+        return {};
+    }
+    manager->Reconfigure(config, std::move(scriptContext),
+                         [&](const std::string& source, Sources& sources) {
+                             InitializeHookedSource(source, sources, mainLoop, *registry,
+                                                    *hooked);
+                             InitializeSource(source, sources, mainLoop, timers, *registry,
+                                              *config);
+                         });
+    return config->files;
+}
+
 int main(int argc, char* argv[]) {
     // Environment variable configurable logging
     spdlog::cfg::load_env_levels();
+    // Block before any threads are started, read by the stats source
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
     // Initialize Lua context
     auto scriptContext = ScriptContext::Create();
     if (!scriptContext) {
@@ -119,18 +213,28 @@ int main(int argc, char* argv[]) {
         spdlog::error("No configuration found");
         return -1;
     }
+    std::shared_ptr<MainLoop> mainLoop = MainLoop::Create();
+    if (!mainLoop) {
+        spdlog::error("Failed to initialize main loop");
+        return -1;
+    }
+    // Timers of configuration, suspended while the overlay is hidden
+    auto timers = Timers::Create(mainLoop);
+    if (!timers) {
+        spdlog::error("Failed to initialize timers");
+        return -1;
+    }
+    // Files read by configuration are invalidated when changed
+    FileCache::Shared().Attach(mainLoop);
+    // Attached before configuration is executed, it might start timers
+    scriptContext->Attach(mainLoop, timers);
     spdlog::info("Loading configuration at: {}", configPath->c_str());
     // Read configuration
-    const auto config = scriptContext->Execute(configPath->c_str());
+    auto config = scriptContext->Execute(configPath->c_str());
     if (!config) {
         spdlog::error("Failed to read configuration");
         return -1;
     }
-    std::shared_ptr<MainLoop> mainLoop = MainLoop::Create();
-    if (!mainLoop) {
-        spdlog::error("Failed to initialize main loop");
-        return -1;
-    }
     // Registry fills the outputs with output instances
     // Initialize registry.
     // The registry initializes roots that contains elementary interfaces needed for the system
@@ -143,29 +247,61 @@ int main(int argc, char* argv[]) {
     // Initialize sources
     auto sources = Sources::Create(std::move(scriptContext));
     scriptContext = nullptr;
-    for (auto panelConfig : config->panels) {
-        //  Check what sources are needed for the widgets in the panel
-        for (const auto& widgetConfig : panelConfig.widgets) {
-            for (const auto& source : widgetConfig.sources) {
-                // Initialize source if not already done
-                if (!sources->IsRegistered(source)) {
-                    InitializeSource(source, *sources, mainLoop, *registry, *config);
+    // Alerts are always maintained, sources raises alerts regardless of the alert panel using them
+    auto alerts = AlertSource::Create(mainLoop, config->alerts);
+    if (!alerts) {
+        spdlog::error("Failed to initialize alerts");
+        return -1;
+    }
+    sources->Register("alerts", alerts);
+    // Stats are always logged on SIGUSR1
+    auto hooked = std::make_shared<HookedSources>();
+    hooked->stats = StatsSource::Create(mainLoop, false);
+    {
+        // Scoped, copies of panels must not outlive a reload
+        auto panelConfigs = config->panels;
+        panelConfigs.push_back(config->alertPanel);
+        for (const auto& panelConfig : panelConfigs) {
+            //  Check what sources are needed for the widgets in the panel
+            for (const auto& widgetConfig : panelConfig.widgets) {
+                for (const auto& source : widgetConfig.sources) {
+                    // Initialize source if not already done
+                    if (!sources->IsRegistered(source)) {
+                        InitializeHookedSource(source, *sources, mainLoop, *registry, *hooked);
+                        InitializeSource(source, *sources, mainLoop, timers, *registry,
+                                         *config);
+                    }
                 }
             }
         }
     }
     // Manager handles displays and redrawing
-    std::shared_ptr<Manager> manager = Manager::Create(registry);
+    std::shared_ptr<Manager> manager = Manager::Create(registry, alerts);
     // Initialize compositor
     switch (config->displays.compositor) {
         case Compositor::Sway: {
-            auto sway = SwayCompositor::Connect(mainLoop, [manager](bool visible) {
-                if (visible) {
-                    manager->Show();
-                } else {
-                    manager->Hide();
-                }
-            });
+            auto sway = SwayCompositor::Connect(
+                mainLoop,
+                [manager, hooked, timers](bool visible) {
+                    timers->SetVisible(visible);
+                    // Thumbnails are captured after the overlay is hidden to not include it
+                    if (visible) {
+                        if (hooked->thumbnails) {
+                            hooked->thumbnails->SetVisible(visible);
+                        }
+                        manager->Show();
+                    } else {
+                        manager->Hide();
+                        if (hooked->thumbnails) {
+                            hooked->thumbnails->SetVisible(visible);
+                        }
+                    }
+                },
+                [hooked](const Displays& displays) {
+                    if (hooked->thumbnails) {
+                        hooked->thumbnails->Update(displays);
+                    }
+                });
             if (!sway) {
                 spdlog::error("Failed to connect to Sway");
                 return -1;
@@ -182,6 +318,15 @@ int main(int argc, char* argv[]) {
     // Let over control to mainloop and manager
     manager->SetSources(std::move(sources));
     sources = nullptr;
+    // Configuration is reloaded when any of its files change
+    auto watcher = ConfigWatcher::Create(mainLoop, [=]() {
+        return Reload(*configPath, mainLoop, timers, registry, manager, hooked);
+    });
+    if (watcher) {
+        watcher->Watch(config->files);
+    }
+    // Owned by outputs from here on, must be released when reloaded
+    config = nullptr;
     mainLoop->RegisterNotificationHandler(manager);
     mainLoop->Run();
     return 0;
@@ -1,29 +1,84 @@
 #include "zen/util.h"
 
-std::string Util::HtmlEscape(const std::string& s) {
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Escape sequence of a special character, nullptr for characters kept as is
+static inline const char* Escape(char c) {
+    switch (c) {
+        case '&':
+            return "&amp;";
+        case '\"':
+            return "&quot;";
+        case '\'':
+            return "&apos;";
+        case '<':
+            return "&lt;";
+        case '>':
+            return "&gt;";
+        default:
+            return nullptr;
+    }
+}
+
+std::string Util::HtmlEscape(std::string_view s) {
     std::string e;
     e.reserve(s.length());
-    for (auto c : s) {
-        switch (c) {
-            case '&':
-                e.append("&amp;");
-                break;
-            case '\"':
-                e.append("&quot;");
-                break;
-            case '\'':
-                e.append("&apos;");
-                break;
-            case '<':
-                e.append("&lt;");
-                break;
-            case '>':
-                e.append("&gt;");
-                break;
-            default:
-                e += c;
-                break;
+    AppendHtmlEscaped(e, s);
+    return e;
+}
+
+void Util::AppendHtmlEscapedScalar(std::string& out, std::string_view s) {
+    size_t run = 0;
+    for (size_t i = 0; i < s.size(); i++) {
+        auto escape = Escape(s[i]);
+        if (escape) {
+            out.append(s.data() + run, i - run);
+            out.append(escape);
+            run = i + 1;
         }
     }
-    return e;
+    out.append(s.data() + run, s.size() - run);
+}
+
+#if defined(__SSE2__)
+void Util::AppendHtmlEscaped(std::string& out, std::string_view s) {
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i quot = _mm_set1_epi8('\"');
+    const __m128i apos = _mm_set1_epi8('\'');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const char* p = s.data();
+    const char* end = p + s.size();
+    const char* run = p;
+    while (p + 16 <= end) {
+        const __m128i chars = _mm_loadu_si128((const __m128i*)p);
+        const __m128i special =
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, amp), _mm_cmpeq_epi8(chars, quot)),
+                         _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, apos),
+                                                   _mm_cmpeq_epi8(chars, lt)),
+                                      _mm_cmpeq_epi8(chars, gt)));
+        int mask = _mm_movemask_epi8(special);
+        if (mask == 0) {
+            p += 16;
+            continue;
+        }
+        // Escape each special character in the block, the run continues after it
+        while (mask != 0) {
+            const char* at = p + __builtin_ctz(mask);
+            out.append(run, at - run);
+            out.append(Escape(*at));
+            run = at + 1;
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+    out.append(run, p - run);
+    AppendHtmlEscapedScalar(out, std::string_view(p, end - p));
+}
+#else
+void Util::AppendHtmlEscaped(std::string& out, std::string_view s) {
+    AppendHtmlEscapedScalar(out, s);
 }
+#endif